@@ -2,6 +2,7 @@
 
 #include <type_traits>
 
+#include <cstdint>
 #include <functional>
 #include <ostream>
 #include <span>
@@ -23,6 +24,31 @@ namespace posets {
         { t1.print (os) } -> std::same_as<std::ostream&>;
       };
 
+  /// Optional capability of a Vector: a hash consistent with ==, and a sort
+  /// key, i.e., a string of bytes such that comparing the keys of two vectors
+  /// of the same size with memcmp gives the lexicographic order of the
+  /// vectors.
+  template <typename T>
+  concept HashableVector =
+      Vector<T> and requires (const T& t, std::span<unsigned char> key) {
+        { t.hash () } -> std::same_as<size_t>;
+        { t.sort_key_size () } -> std::same_as<size_t>;
+        { t.sort_key (key) };
+      };
+
+  /// Optional capability of a Vector: meets that reuse the storage of an
+  /// existing vector, and joins (componentwise maximum).  meet_into (dst, a,
+  /// b) stores the meet of a and b in dst, which must have the same size, and
+  /// may be a or b.
+  template <typename T>
+  concept LatticeVector =
+      Vector<T> and requires (T& dst, const T& a, const T& b) {
+        T::meet_into (dst, a, b);
+        dst.meet_assign (a);
+        { a.join (b) } -> std::same_as<T>;
+        dst.join_assign (a);
+      };
+
   template <typename T, typename V = typename T::value_type>
   concept Downset =
       std::ranges::range<T> and not std::is_default_constructible_v<T> and
@@ -34,6 +60,7 @@ namespace posets {
       requires (T set, T set2, const T& set3, V vec, std::function<V (const V&)> f) {
         { set.apply (f) } -> std::same_as<T>;
         { set.contains (vec) } -> std::same_as<bool>;
+        { set3.closure_size () } -> std::same_as<uint64_t>;
         set.union_with (std::move (set2));
         set.intersect_with (std::move (set2));
         { set.get_backing_vector ().clear () } -> std::same_as<void>;
@@ -1,7 +1,12 @@
 #pragma once
 
 #include <posets/concepts.hh>
+#include <posets/downsets/adaptive_backed.hh>
+#include <posets/downsets/bitmap_backed.hh>
+#include <posets/downsets/columnar_backed.hh>
+#include <posets/downsets/dimension_dispatched.hh>
 #include <posets/downsets/full_set.hh>
+#include <posets/downsets/interned_backed.hh>
 #include <posets/downsets/kdtree_backed.hh>
 #include <posets/downsets/set_backed.hh>
 #include <posets/downsets/sharingtree_backed.hh>
@@ -14,7 +19,11 @@
 #include <posets/vectors.hh>
 
 namespace posets::downsets {
+  static_assert (Downset<adaptive_backed<posets::vectors::vector_backed<int>>>);
+  static_assert (Downset<bitmap_backed<posets::vectors::vector_backed<int>>>);
+  static_assert (Downset<columnar_backed<posets::vectors::vector_backed<int>>>);
   static_assert (Downset<full_set<posets::vectors::vector_backed<int>>>);
+  static_assert (Downset<interned_backed<posets::vectors::vector_backed<int>>>);
   static_assert (Downset<kdtree_backed<posets::vectors::vector_backed<int>>>);
   static_assert (Downset<vector_backed<posets::vectors::vector_backed<int>>>);
   static_assert (Downset<vector_or_kdtree_backed<posets::vectors::vector_backed<int>>>);
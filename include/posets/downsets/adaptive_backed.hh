@@ -0,0 +1,401 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <span>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <posets/concepts.hh>
+#include <posets/downsets/kdtree_backed.hh>
+#include <posets/downsets/sharingtree_backed.hh>
+#include <posets/downsets/sharingtrie_backed.hh>
+#include <posets/downsets/vector_backed.hh>
+
+// The backend is only replaced when its predicted cost is at least this many
+// times that of the best one, and the predicted savings since that started
+// being the case pay for the conversion.
+#ifndef ADAPTIVE_HYSTERESIS
+# define ADAPTIVE_HYSTERESIS 2.0
+#endif
+
+// The calibration times each operation on antichains of about this size and
+// of an eighth of it.
+#ifndef ADAPTIVE_CALIBRATION_SIZE
+# define ADAPTIVE_CALIBRATION_SIZE 128UL
+#endif
+
+namespace posets::downsets {
+  /// The cost, in seconds, of an operation on an input of size x: c * x^e.
+  struct power_law {
+      double c = 0;
+      double e = 1;
+
+      [[nodiscard]] double operator() (double x) const {
+        return c * std::pow (std::max (x, 1.), e);
+      }
+
+      /// The power law through (x1, t1) and (x2, t2), with x1 <= x2.  The
+      /// exponent is taken to be 1 if the sizes are too close to tell.
+      static power_law fit (double x1, double t1, double x2, double t2) {
+        t1 = std::max (t1, 1e-9);
+        t2 = std::max (t2, 1e-9);
+        if (x2 < 2 * x1)
+          return {t2 / std::max (x2, 1.), 1};
+        const double e = std::clamp (std::log (t2 / t1) / std::log (x2 / x1), 0., 3.);
+        return {t2 / std::pow (x2, e), e};
+      }
+  };
+
+  /// The cost model of a backend.  The size of the input is the size of the
+  /// antichain for build and contains (per query), the sum of the sizes for
+  /// union_with, and their product for intersect_with.
+  struct backend_costs {
+      power_law build, contains, unite, intersect;
+  };
+
+  template <template <typename> typename... Backends>
+  struct backend_list {};
+
+  using default_adaptive_backends =
+      backend_list<vector_backed, kdtree_backed, sharingtree_backed, sharingtrie_backed>;
+
+  namespace adaptive_details {
+    // A query counter that can be bumped from const member functions, which
+    // may run concurrently.
+    struct counter {
+        counter () = default;
+        counter (counter&& other) noexcept : n {other.n.load (std::memory_order_relaxed)} {}
+        counter& operator= (counter&& other) noexcept {
+          n.store (other.n.load (std::memory_order_relaxed), std::memory_order_relaxed);
+          return *this;
+        }
+
+        void bump () const { n.fetch_add (1, std::memory_order_relaxed); }
+        size_t take () { return n.exchange (0, std::memory_order_relaxed); }
+
+        mutable std::atomic<size_t> n {0};
+    };
+  }
+
+  template <Vector V, typename Backends = default_adaptive_backends>
+  class adaptive_backed;
+
+  // A downset held by whichever of Backends is predicted to be the cheapest
+  // for the size of the antichain and the recent mix of operations.  The
+  // prediction uses, for each backend, power laws fitted to the timings of a
+  // small benchmark run the first time a dimension is seen (or given with
+  // set_costs).  Since the antichains can grow and shrink by orders of
+  // magnitude, the choice is made again after each union and intersection;
+  // a switch must pay for its conversion, so that the downset does not
+  // bounce between two backends of similar costs.
+  template <Vector V, template <typename> typename... Backends>
+  class adaptive_backed<V, backend_list<Backends...>> {
+      using variant_t = std::variant<Backends<V>...>;
+      static constexpr size_t nbackends = sizeof...(Backends);
+
+    public:
+      using value_type = V;
+      using costs_t = std::array<backend_costs, nbackends>;
+
+      adaptive_backed () = delete;
+      adaptive_backed (const adaptive_backed&) = delete;
+      adaptive_backed (adaptive_backed&&) = default;
+      adaptive_backed& operator= (const adaptive_backed&) = delete;
+      adaptive_backed& operator= (adaptive_backed&&) = default;
+
+      adaptive_backed (std::vector<V>&& elements) noexcept
+        : downset {make (initial_backend (elements), std::move (elements))} {}
+
+      adaptive_backed (V&& v) : downset {std::in_place_index<0>, std::move (v)} {}
+
+      /// The index in Backends of the backend holding the downset.
+      [[nodiscard]] size_t backend () const { return downset.index (); }
+
+      [[nodiscard]] size_t size () const {
+        return std::visit ([] (const auto& d) { return static_cast<size_t> (d.size ()); },
+                           downset);
+      }
+
+      [[nodiscard]] uint64_t closure_size () const {
+        return std::visit ([] (const auto& d) { return d.closure_size (); }, downset);
+      }
+
+      [[nodiscard]] auto& get_backing_vector () {
+        return std::visit ([] (auto& d) -> std::vector<V>& { return d.get_backing_vector (); },
+                           downset);
+      }
+
+      [[nodiscard]] const auto& get_backing_vector () const {
+        return std::visit (
+            [] (const auto& d) -> const std::vector<V>& { return d.get_backing_vector (); },
+            downset);
+      }
+
+      auto begin () { return get_backing_vector ().begin (); }
+      [[nodiscard]] auto begin () const { return get_backing_vector ().begin (); }
+      auto end () { return get_backing_vector ().end (); }
+      [[nodiscard]] auto end () const { return get_backing_vector ().end (); }
+
+      [[nodiscard]] bool contains (const V& v) const {
+        queries.bump ();
+        return std::visit ([&v] (const auto& d) { return d.contains (v); }, downset);
+      }
+
+      // Union in place; other is converted to our backend if needed.
+      void union_with (adaptive_backed&& other) {
+        if (other.downset.index () != downset.index ())
+          other.convert_to (downset.index ());
+        with_index ([&] (auto i) {
+          std::get<i> (downset).union_with (std::move (std::get<i> (other.downset)));
+        });
+        unions += 1;
+        adapt ();
+      }
+
+      // Intersection in place.  If the backends differ, we move to the
+      // backend of other, which is cheaper than copying it.
+      void intersect_with (const adaptive_backed& other) {
+        if (other.downset.index () != downset.index ())
+          convert_to (other.downset.index ());
+        with_index ([&] (auto i) {
+          std::get<i> (downset).intersect_with (std::get<i> (other.downset));
+        });
+        intersections += 1;
+        adapt ();
+      }
+
+      template <typename F>
+      auto apply (const F& lambda) const {
+        const auto& backing_vector = get_backing_vector ();
+        std::vector<V> ss;
+        ss.reserve (backing_vector.size ());
+        for (const auto& v : backing_vector)
+          ss.push_back (lambda (v));
+        return adaptive_backed (std::move (ss));
+      }
+
+      /// The cost model for vectors of dimension dim, calibrated on first use.
+      static costs_t costs (size_t dim) {
+        std::lock_guard lock {models_mutex};
+        auto it = models.find (dim);
+        if (it == models.end ())
+          it = models.emplace (dim, calibrate (dim)).first;
+        return it->second;
+      }
+
+      /// Use the given cost model for vectors of dimension dim, e.g., one
+      /// computed offline by calibrate (), instead of calibrating.
+      static void set_costs (size_t dim, const costs_t& c) {
+        std::lock_guard lock {models_mutex};
+        models.insert_or_assign (dim, c);
+      }
+
+      /// Time each operation of each backend on random antichains of vectors
+      /// of dimension dim, and fit power laws to the timings.  The components
+      /// are within [0, 2], so that any vector type can hold them.
+      static costs_t calibrate (size_t dim) {
+        std::mt19937 gen {0};
+        const std::array<size_t, 2> sizes {ADAPTIVE_CALIBRATION_SIZE / 8,
+                                           ADAPTIVE_CALIBRATION_SIZE};
+        auto timed = [] (auto&& f) {
+          const auto start = std::chrono::steady_clock::now ();
+          f ();
+          const auto stop = std::chrono::steady_clock::now ();
+          return std::chrono::duration<double> (stop - start).count ();
+        };
+
+        costs_t res;
+        for_each_backend ([&] (auto b) {
+          std::array<std::array<double, 2>, 4> x {}, t {};
+          for (size_t s = 0; s < 2; ++s) {
+            using backend_t = std::variant_alternative_t<b, variant_t>;
+            auto sample = [&] { return backend_t (antichain (gen, dim, sizes[s])); };
+
+            // Best of three, to smooth out the noise of small timings.
+            double build = 1e9, query = 1e9, unite = 1e9, intersect = 1e9;
+            size_t m = 0, me = 0;
+            for (int rep = 0; rep < 3; ++rep) {
+              auto elements = antichain (gen, dim, sizes[s]);
+              build = std::min (build, timed ([&] {
+                backend_t d (std::move (elements));
+                m = d.size ();
+              }));
+
+              auto d = sample ();
+              auto probes = random_vectors (gen, dim, 64);
+              size_t found = 0;
+              query = std::min (query, timed ([&] {
+                          for (const auto& p : probes)
+                            found += d.contains (p);
+                        }) / probes.size ());
+              [[maybe_unused]] volatile size_t sink = found;
+
+              // The intersection makes up to the product of the sizes, so
+              // the second operand is kept small.
+              auto e = backend_t (antichain (gen, dim, sizes[0]));
+              me = e.size ();
+              intersect = std::min (intersect, timed ([&] { d.intersect_with (e); }));
+              auto f = sample (), g = sample ();
+              unite = std::min (unite, timed ([&] { f.union_with (std::move (g)); }));
+            }
+            const double md = std::max<double> (m, 1);
+            x[0][s] = md, t[0][s] = build;
+            x[1][s] = md, t[1][s] = query;
+            x[2][s] = 2 * md, t[2][s] = unite;
+            x[3][s] = md * std::max<double> (me, 1), t[3][s] = intersect;
+          }
+          auto law = [&] (size_t op) {
+            return power_law::fit (x[op][0], t[op][0], x[op][1], t[op][1]);
+          };
+          res[b] = {law (0), law (1), law (2), law (3)};
+        });
+        return res;
+      }
+
+    private:
+      adaptive_backed (variant_t&& downset) : downset {std::move (downset)} {}
+
+      // Construct backend b from elements.
+      template <size_t I = 0>
+      static variant_t make (size_t b, std::vector<V>&& elements) {
+        if constexpr (I + 1 < nbackends)
+          if (b != I)
+            return make<I + 1> (b, std::move (elements));
+        return variant_t (std::in_place_index<I>, std::move (elements));
+      }
+
+      void convert_to (size_t b) {
+        downset = make (b, std::move (get_backing_vector ()));
+      }
+
+      // The predicted cost of one more round of operations, following the
+      // recent mix, for backend b with an antichain of size m.
+      double round_cost (const backend_costs& c, double m) const {
+        const double rounds = std::max (unions + intersections, 1e-3);
+        return (recent_queries / rounds * c.contains (m)) + (unions / rounds * c.unite (2 * m))
+               + (intersections / rounds * c.intersect (m * m));
+      }
+
+      // Called while downset is initialized, after the counters of the mix.
+      size_t initial_backend (const std::vector<V>& elements) const {
+        assert (not elements.empty ());
+        const double m = elements.size ();
+        const auto c = costs (elements.front ().size ());
+        size_t best = 0;
+        double best_cost = 0;
+        for (size_t b = 0; b < nbackends; ++b) {
+          const double cost = c[b].build (m) + round_cost (c[b], m);
+          if (b == 0 or cost < best_cost)
+            best = b, best_cost = cost;
+        }
+        return best;
+      }
+
+      void adapt () {
+        // The mix of operations is an exponentially weighted average, so
+        // that it follows the phases of the computation.
+        recent_queries += queries.take ();
+        const size_t m = size ();
+        const auto c = costs (get_backing_vector ().front ().size ());
+        const size_t cur = downset.index ();
+        size_t best = cur;
+        for (size_t b = 0; b < nbackends; ++b)
+          if (round_cost (c[b], m) < round_cost (c[best], m))
+            best = b;
+
+        const double cur_cost = round_cost (c[cur], m), best_cost = round_cost (c[best], m);
+        if (best != cur and cur_cost > ADAPTIVE_HYSTERESIS * best_cost) {
+          regret += cur_cost - best_cost;
+          if (regret >= c[best].build (m)) {
+            convert_to (best);
+            regret = 0;
+          }
+        }
+        else
+          regret = 0;
+
+        recent_queries *= .75;
+        unions *= .75;
+        intersections *= .75;
+      }
+
+      // Call f (std::integral_constant<size_t, downset.index ()> {}).
+      template <size_t I = 0, typename F>
+      decltype (auto) with_index (F&& f) const {
+        if constexpr (I + 1 == nbackends)
+          return f (std::integral_constant<size_t, I> {});
+        else {
+          if (downset.index () == I)
+            return f (std::integral_constant<size_t, I> {});
+          return with_index<I + 1> (std::forward<F> (f));
+        }
+      }
+
+      template <size_t I = 0, typename F>
+      static void for_each_backend (F&& f) {
+        if constexpr (I < nbackends) {
+          f (std::integral_constant<size_t, I> {});
+          for_each_backend<I + 1> (std::forward<F> (f));
+        }
+      }
+
+      static std::vector<V> random_vectors (std::mt19937& gen, size_t dim, size_t n) {
+        std::uniform_int_distribution<int> comp (0, 2);
+        std::vector<typename V::value_type> buf (dim);
+        std::vector<V> res;
+        res.reserve (n);
+        for (size_t i = 0; i < n; ++i) {
+          for (auto& x : buf)
+            x = static_cast<typename V::value_type> (comp (gen));
+          res.emplace_back (V (std::span<const typename V::value_type> (buf)));
+        }
+        return res;
+      }
+
+      // Vectors whose components add up to dim, which are incomparable.
+      // There may be fewer than n different ones in small dimensions.
+      static std::vector<V> antichain (std::mt19937& gen, size_t dim, size_t n) {
+        std::uniform_int_distribution<size_t> pos (0, dim - 1);
+        std::vector<typename V::value_type> buf (dim);
+        std::vector<V> res;
+        res.reserve (n);
+        for (size_t i = 0; i < n; ++i) {
+          std::fill (buf.begin (), buf.end (), 0);
+          for (size_t k = 0; k < dim;) {
+            auto& x = buf[pos (gen)];
+            if (x < 2)
+              ++x, ++k;
+          }
+          res.emplace_back (V (std::span<const typename V::value_type> (buf)));
+        }
+        return res;
+      }
+
+      // Declared before downset, whose initialization reads them.
+      adaptive_details::counter queries;
+      double recent_queries = 1, unions = 1, intersections = 1;
+      double regret = 0;
+      variant_t downset;
+
+      static inline std::mutex models_mutex;
+      static inline std::map<size_t, costs_t> models;
+  };
+
+  template <Vector V, typename Backends>
+  inline std::ostream& operator<< (std::ostream& os, const adaptive_backed<V, Backends>& f) {
+    for (auto&& el : f.get_backing_vector ())
+      os << el << std::endl;
+    return os;
+  }
+}
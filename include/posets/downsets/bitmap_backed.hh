@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <posets/concepts.hh>
+#include <posets/utils/lattice_bitmap.hh>
+
+// The largest box, in points, that a set may span.  The bitmap of a box of
+// that size takes 32MB.
+#ifndef BITMAP_BACKED_MAX_POINTS
+# define BITMAP_BACKED_MAX_POINTS (1UL << 28)
+#endif
+
+namespace posets::downsets {
+  // A downset stored as the bitmap of its points in a box [lo, lo + 2^w),
+  // where lo is the componentwise minimum of the elements and the sides are
+  // rounded up to powers of two (see utils::lattice_bitmap).  A vector below
+  // lo is in the set if its componentwise max with lo is.  Membership is a
+  // single bit test, and union and intersection are ORs and ANDs of the
+  // bitmaps, once they are laid out over the same box.
+  //
+  // This is meant for small domains.  The box from lo to the componentwise
+  // maximum of the elements, with its sides rounded up to powers of two,
+  // must have at most BITMAP_BACKED_MAX_POINTS points; the constructors and
+  // union_with throw std::length_error otherwise.  An intersection is never
+  // larger than either of its operands.
+  //
+  // The maximal elements are only extracted from the bitmap when they are
+  // asked for, and then kept until the set changes.
+  template <Vector V>
+  class bitmap_backed {
+      using T = typename V::value_type;
+
+    public:
+      using value_type = V;
+
+      bitmap_backed (V&& v) : bitmap_backed (singleton (std::move (v))) {}
+
+      bitmap_backed (std::vector<V>&& elements) :
+        lo (lower_corner (elements)), hi (upper_corner (elements)), bitmap (box_widths (lo, hi)) {
+        for (const auto& e : elements)
+          bitmap.set (rank (e));
+        bitmap.close_downward ();
+      }
+
+      bitmap_backed (const bitmap_backed&) = delete;
+      bitmap_backed (bitmap_backed&&) = default;
+      bitmap_backed& operator= (const bitmap_backed&) = delete;
+      bitmap_backed& operator= (bitmap_backed&&) = default;
+
+      [[nodiscard]] bool contains (const V& v) const {
+        uint64_t r = 0;
+        for (size_t i = 0; i < lo.size (); ++i) {
+          const auto c = static_cast<uint64_t> (std::max<long> (v[i], lo[i]) - lo[i]);
+          if (c >> bitmap.width (i))
+            return false;
+          r |= c << bitmap.shift (i);
+        }
+        return bitmap.test (r);
+      }
+
+      [[nodiscard]] auto size () const { return maximal_elements ().size (); }
+
+      // A point p of the box stands for the vectors down to -1 that are
+      // clamped to p: lo[i] + 2 values along the components where p is at
+      // lo, and one elsewhere; none if a component of p is below -1.
+      [[nodiscard]] uint64_t closure_size () const {
+        if (std::ranges::all_of (lo, [] (long l) { return l == -1; }))
+          return bitmap.count ();
+        uint64_t total = 0;
+        bitmap.for_each ([&] (uint64_t r) {
+          uint64_t n = 1;
+          for (size_t i = 0; i < lo.size () and n != 0; ++i) {
+            const auto c = offset (r, i);
+            if (lo[i] + c < -1)
+              n = 0;
+            else if (c == 0)
+              n *= static_cast<uint64_t> (lo[i] + 2);
+          }
+          total += n;
+        });
+        return total;
+      }
+
+      void union_with (const bitmap_backed& other) {
+        std::vector<long> top (hi.size ());
+        for (size_t i = 0; i < hi.size (); ++i)
+          top[i] = std::max (hi[i], other.hi[i]);
+        combine (other, std::move (top),
+                 [this] (const utils::lattice_bitmap& b) { bitmap.or_with (b); });
+      }
+
+      void intersect_with (const bitmap_backed& other) {
+        std::vector<long> top (hi.size ());
+        for (size_t i = 0; i < hi.size (); ++i)
+          top[i] = std::min (hi[i], other.hi[i]);
+        combine (other, std::move (top),
+                 [this] (const utils::lattice_bitmap& b) { bitmap.and_with (b); });
+      }
+
+      template <typename F>
+      bitmap_backed apply (const F& lambda) const {
+        std::vector<V> elements;
+        elements.reserve (size ());
+        for (const auto& el : maximal_elements ())
+          elements.push_back (lambda (el));
+        return bitmap_backed (std::move (elements));
+      }
+
+      // The bitmap is not updated if the backing vector is modified; this is
+      // meant for moving the elements out.
+      [[nodiscard]] auto& get_backing_vector () {
+        maximal_elements ();
+        return antichain;
+      }
+
+      [[nodiscard]] const auto& get_backing_vector () const { return maximal_elements (); }
+
+      [[nodiscard]] auto begin () const { return maximal_elements ().begin (); }
+
+      [[nodiscard]] auto end () const { return maximal_elements ().end (); }
+
+    private:
+      std::vector<long> lo;
+      // The elements are at most hi - 1; the box may extend past it.
+      std::vector<long> hi;
+      utils::lattice_bitmap bitmap;
+      mutable std::vector<V> antichain;
+      mutable bool antichain_valid = false;
+
+      static std::vector<V> singleton (V&& v) {
+        std::vector<V> elements;
+        elements.push_back (std::move (v));
+        return elements;
+      }
+
+      static std::vector<long> lower_corner (const std::vector<V>& elements) {
+        const size_t dim = elements.at (0).size ();
+        std::vector<long> corner (dim);
+        for (size_t i = 0; i < dim; ++i) {
+          corner[i] = elements[0][i];
+          for (const auto& e : elements)
+            corner[i] = std::min<long> (corner[i], e[i]);
+        }
+        return corner;
+      }
+
+      static std::vector<long> upper_corner (const std::vector<V>& elements) {
+        std::vector<long> corner (elements.at (0).size ());
+        for (size_t i = 0; i < corner.size (); ++i) {
+          corner[i] = elements[0][i] + 1;
+          for (const auto& e : elements)
+            corner[i] = std::max<long> (corner[i], e[i] + 1);
+        }
+        return corner;
+      }
+
+      // Box sides large enough to hold the points up to top[i] - 1.
+      static std::vector<unsigned> box_widths (const std::vector<long>& corner,
+                                               const std::vector<long>& top) {
+        std::vector<unsigned> widths;
+        unsigned total = 0;
+        for (size_t i = 0; i < corner.size (); ++i) {
+          widths.push_back (std::bit_width (static_cast<uint64_t> (top[i] - corner[i] - 1)));
+          total += widths.back ();
+        }
+        if (total >= 64 or (uint64_t {1} << total) > BITMAP_BACKED_MAX_POINTS)
+          throw std::length_error ("bitmap_backed: the box of the set is too large");
+        return widths;
+      }
+
+      // Component i of the point of rank r, minus lo[i].
+      [[nodiscard]] long offset (uint64_t r, size_t i) const {
+        return static_cast<long> ((r >> bitmap.shift (i)) &
+                                  ((uint64_t {1} << bitmap.width (i)) - 1));
+      }
+
+      [[nodiscard]] uint64_t rank (const V& v) const {
+        uint64_t r = 0;
+        for (size_t i = 0; i < lo.size (); ++i)
+          r |= static_cast<uint64_t> (v[i] - lo[i]) << bitmap.shift (i);
+        return r;
+      }
+
+      // The bitmap of this set over the box with lower corner corner and
+      // sides widths; corner is below lo, and the maximal elements that go
+      // past the box are clamped to it.
+      [[nodiscard]] utils::lattice_bitmap laid_out (const std::vector<long>& corner,
+                                                    const std::vector<unsigned>& widths) const {
+        utils::lattice_bitmap res (widths);
+        bitmap.maxima ().for_each ([&] (uint64_t r) {
+          uint64_t to = 0;
+          for (size_t i = 0; i < lo.size (); ++i) {
+            const auto c = std::min ((1L << res.width (i)) - 1, offset (r, i) + lo[i] - corner[i]);
+            to |= static_cast<uint64_t> (c) << res.shift (i);
+          }
+          res.set (to);
+        });
+        res.close_downward ();
+        return res;
+      }
+
+      // Lay out both sets over the box from their lowest corner to top, the
+      // upper corner of the result, if they differ, then apply op to the
+      // bitmap of this set and that of other.
+      template <typename Op>
+      void combine (const bitmap_backed& other, std::vector<long>&& top, const Op& op) {
+        antichain_valid = false;
+        if (lo == other.lo and bitmap.same_shape (other.bitmap)) {
+          hi = std::move (top);
+          op (other.bitmap);
+          return;
+        }
+
+        std::vector<long> corner (lo.size ());
+        for (size_t i = 0; i < lo.size (); ++i)
+          corner[i] = std::min (lo[i], other.lo[i]);
+        const auto widths = box_widths (corner, top);
+        bitmap = laid_out (corner, widths);
+        lo = std::move (corner);
+        hi = std::move (top);
+        if (other.lo == lo and other.bitmap.same_shape (bitmap))
+          op (other.bitmap);
+        else
+          op (other.laid_out (lo, widths));
+      }
+
+      const std::vector<V>& maximal_elements () const {
+        if (antichain_valid)
+          return antichain;
+        antichain.clear ();
+        std::vector<T> buf (lo.size ());
+        bitmap.maxima ().for_each ([&] (uint64_t r) {
+          for (size_t i = 0; i < lo.size (); ++i)
+            buf[i] = static_cast<T> (lo[i] + offset (r, i));
+          antichain.push_back (V (std::span<const T> (buf)));
+        });
+        antichain_valid = true;
+        return antichain;
+      }
+  };
+
+  template <Vector V>
+  inline std::ostream& operator<< (std::ostream& os, const bitmap_backed<V>& f) {
+    for (auto&& el : f)
+      os << el << std::endl;
+
+    return os;
+  }
+}
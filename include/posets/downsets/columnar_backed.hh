@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <posets/concepts.hh>
+#include <posets/utils/columnar.hh>
+#include <posets/utils/skyline.hh>
+
+namespace posets::downsets {
+  // An antichain stored both as a vector of rows (for iteration) and
+  // transposed, one contiguous column per dimension.  Domination checks
+  // compare the query against a whole SIMD block of antichain elements at
+  // once, see utils::columnar.
+  template <Vector V>
+  class columnar_backed {
+    public:
+      using value_type = V;
+
+      columnar_backed (V&& v) : columns {v.size ()} { insert (std::move (v)); }
+
+      columnar_backed (std::vector<V>&& elements) noexcept
+        : vector_set {utils::skyline (std::move (elements))},
+          columns {vector_set.empty () ? 0 : vector_set[0].size ()} {
+        assert (not vector_set.empty ());
+        columns.reserve (vector_set.size ());
+        for (const auto& e : vector_set)
+          columns.push_back (e);
+      }
+
+    private:
+      columnar_backed (size_t dim) : columns {dim} {}
+
+    public:
+      columnar_backed (const columnar_backed&) = delete;
+      columnar_backed (columnar_backed&&) = default;
+      columnar_backed& operator= (columnar_backed&&) = default;
+      columnar_backed& operator= (const columnar_backed&) = delete;
+
+      bool operator== (const columnar_backed& other) = delete;
+
+      [[nodiscard]] bool contains (const V& v) const { return columns.any_geq (v); }
+
+      [[nodiscard]] auto size () const { return vector_set.size (); }
+
+      bool insert (V&& v) {
+        using lane_mask = typename utils::columnar<typename V::value_type>::lane_mask;
+        const size_t nblocks = columns.nblocks ();
+        removed.assign (nblocks, 0);
+        bool must_remove = false;
+
+        for (size_t b = 0; b < nblocks; ++b) {
+          lane_mask geq;
+          lane_mask leq;
+          // Once v is known to dominate an element, it can't be dominated
+          // since we started with an antichain.
+          columns.compare_block (b, v, must_remove ? nullptr : &geq, &leq);
+          if (not must_remove and geq)  // v is dominated.
+            return false;
+          removed[b] = leq;
+          must_remove or_eq (leq != 0);
+        }
+
+        if (must_remove) {
+          columns.erase (removed);
+          size_t kept = 0;
+          for (size_t r = 0; r < vector_set.size (); ++r)
+            if (not (removed[r / lanes] & (lane_mask {1} << (r % lanes)))) {
+              if (kept != r)
+                vector_set[kept] = std::move (vector_set[r]);
+              ++kept;
+            }
+          vector_set.erase (vector_set.begin () + kept, vector_set.end ());
+        }
+
+        columns.push_back (v);
+        vector_set.push_back (std::move (v));
+        assert (columns.size () == vector_set.size ());
+        return true;
+      }
+
+      void union_with (columnar_backed&& other) {
+        for (auto&& e : other.vector_set)
+          insert (std::move (e));
+      }
+
+      void intersect_with (const columnar_backed& other) {
+        columnar_backed intersection (columns.dimension ());
+        bool smaller_set = false;
+
+        for (const auto& x : vector_set) {
+          // If x is dominated by other, then it is in the intersection and
+          // dominates all the meets it would produce.
+          if (other.contains (x)) {
+            intersection.insert (x.copy ());
+            continue;
+          }
+          smaller_set = true;
+          for (const auto& y : other.vector_set)
+            intersection.insert (x.meet (y));
+        }
+
+        if (smaller_set)
+          *this = std::move (intersection);
+      }
+
+      template <typename F>
+      columnar_backed apply (const F& lambda) const {
+        columnar_backed res (columns.dimension ());
+        for (const auto& el : vector_set)
+          res.insert (lambda (el));
+        return res;
+      }
+
+      [[nodiscard]] auto begin () const { return vector_set.begin (); }
+      [[nodiscard]] auto end () const { return vector_set.end (); }
+
+      // Note that the columns are not updated if the backing vector is
+      // modified; this is meant for moving the elements out.
+      [[nodiscard]] auto& get_backing_vector () { return vector_set; }
+      [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
+
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
+
+    private:
+      static constexpr auto lanes = utils::columnar<typename V::value_type>::lanes;
+
+      std::vector<V> vector_set;
+      utils::columnar<typename V::value_type> columns;
+      // Scratch space for insert, kept to avoid an allocation per call.
+      std::vector<typename utils::columnar<typename V::value_type>::lane_mask> removed;
+  };
+
+  template <Vector V>
+  inline std::ostream& operator<< (std::ostream& os, const columnar_backed<V>& f) {
+    for (auto&& el : f)
+      os << el << std::endl;
+
+    return os;
+  }
+}
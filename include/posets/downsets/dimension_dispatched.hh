@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <posets/concepts.hh>
+#include <posets/utils/dimension_dispatch.hh>
+#include <posets/vectors.hh>
+
+namespace posets::downsets {
+  namespace dimension_dispatched_details {
+    template <typename Buckets, template <typename> typename Downset, typename T,
+              template <typename, size_t> typename FixedVector,
+              template <typename> typename DynamicVector>
+    struct variant_of;
+
+    template <size_t... Ks, template <typename> typename Downset, typename T,
+              template <typename, size_t> typename FixedVector,
+              template <typename> typename DynamicVector>
+    struct variant_of<utils::dimension_buckets<Ks...>, Downset, T, FixedVector, DynamicVector> {
+        using type = std::variant<Downset<FixedVector<T, Ks>>..., Downset<DynamicVector<T>>>;
+    };
+  }
+
+  // A downset whose dimension is only known at runtime.  It holds a
+  // Downset<FixedVector<T, K>> for the smallest K in Buckets that fits the
+  // dimension, or a Downset<DynamicVector<T>> if none does.  The alternative
+  // is selected once per operation on the downset, so that the vectors are
+  // compared with the code of the fixed-size type, without indirection.
+  //
+  // Vectors cross the interface as spans of T; visit () gives access to the
+  // underlying downset.
+  template <template <typename> typename Downset, typename T,
+            template <typename, size_t> typename FixedVector = vectors::simd_array_backed,
+            template <typename> typename DynamicVector = vectors::simd_vector_backed,
+            typename Buckets = utils::default_dimension_buckets>
+  class dimension_dispatched {
+      using variant_t =
+          typename dimension_dispatched_details::variant_of<Buckets, Downset, T, FixedVector,
+                                                            DynamicVector>::type;
+
+      template <size_t I>
+      using downset_t = std::variant_alternative_t<I, variant_t>;
+
+    public:
+      using value_type = T;
+
+      dimension_dispatched (std::span<const T> v)
+        : dim {v.size ()},
+          downset {Buckets::with_bucket (dim, [&v] (auto i) {
+            using V = typename downset_t<i>::value_type;
+            return variant_t (std::in_place_index<i>, V (v));
+          })} {}
+
+      // All the elements should have the same, nonzero, size.
+      dimension_dispatched (const std::vector<std::vector<T>>& elements)
+        : dim {elements.at (0).size ()},
+          downset {Buckets::with_bucket (dim, [&elements] (auto i) {
+            using V = typename downset_t<i>::value_type;
+            std::vector<V> vs;
+            vs.reserve (elements.size ());
+            for (const auto& e : elements) {
+              assert (e.size () == elements[0].size ());
+              vs.emplace_back (V (std::span<const T> (e)));
+            }
+            return variant_t (std::in_place_index<i>, std::move (vs));
+          })} {}
+
+    private:
+      dimension_dispatched (size_t dim, variant_t&& downset)
+        : dim {dim},
+          downset {std::move (downset)} {}
+
+    public:
+      dimension_dispatched (const dimension_dispatched&) = delete;
+      dimension_dispatched (dimension_dispatched&&) = default;
+      dimension_dispatched& operator= (dimension_dispatched&&) = default;
+      dimension_dispatched& operator= (const dimension_dispatched&) = delete;
+
+      [[nodiscard]] size_t dimension () const { return dim; }
+
+      /// The bucket holding the downset, or 0 if it uses DynamicVector.
+      [[nodiscard]] size_t bucket () const {
+        return downset.index () < Buckets::count ? Buckets::sizes[downset.index ()] : 0;
+      }
+
+      [[nodiscard]] size_t size () const {
+        return visit ([] (const auto& d) { return static_cast<size_t> (d.size ()); });
+      }
+
+      [[nodiscard]] uint64_t closure_size () const {
+        return visit ([] (const auto& d) { return d.closure_size (); });
+      }
+
+      [[nodiscard]] bool contains (std::span<const T> v) const {
+        assert (v.size () == dim);
+        return visit ([&v] (const auto& d) {
+          using V = typename std::remove_cvref_t<decltype (d)>::value_type;
+          return d.contains (V (v));
+        });
+      }
+
+      void union_with (dimension_dispatched&& other) {
+        assert (other.dim == dim and other.downset.index () == downset.index ());
+        with_index ([&] (auto i) {
+          std::get<i> (downset).union_with (std::move (std::get<i> (other.downset)));
+        });
+      }
+
+      void intersect_with (const dimension_dispatched& other) {
+        assert (other.dim == dim and other.downset.index () == downset.index ());
+        with_index ([&] (auto i) {
+          std::get<i> (downset).intersect_with (std::get<i> (other.downset));
+        });
+      }
+
+      /// f is called on the vectors of the underlying downset, and should
+      /// accept all the vector types (e.g., be a generic lambda).
+      template <typename F>
+      dimension_dispatched apply (const F& f) const {
+        return with_index ([&] (auto i) {
+          return dimension_dispatched (dim,
+                                       variant_t (std::in_place_index<i>,
+                                                  std::get<i> (downset).apply (f)));
+        });
+      }
+
+      /// Call f (std::span<const T>) on each element.
+      template <typename F>
+      void for_each (F&& f) const {
+        std::vector<T> buf (dim);
+        visit ([&] (const auto& d) {
+          for (const auto& e : d) {
+            e.to_vector (buf);
+            f (std::span<const T> (buf));
+          }
+        });
+      }
+
+      /// Call f on the underlying downset.
+      template <typename F>
+      decltype (auto) visit (F&& f) {
+        return std::visit (std::forward<F> (f), downset);
+      }
+
+      template <typename F>
+      decltype (auto) visit (F&& f) const {
+        return std::visit (std::forward<F> (f), downset);
+      }
+
+    private:
+      // Call f (std::integral_constant<size_t, downset.index ()> {}).  The
+      // alternatives may repeat a type, so std::visit would not tell them
+      // apart.
+      template <size_t I = 0, typename F>
+      decltype (auto) with_index (F&& f) const {
+        if constexpr (I + 1 == std::variant_size_v<variant_t>)
+          return f (std::integral_constant<size_t, I> {});
+        else {
+          if (downset.index () == I)
+            return f (std::integral_constant<size_t, I> {});
+          return with_index<I + 1> (std::forward<F> (f));
+        }
+      }
+
+      size_t dim;
+      variant_t downset;
+  };
+}
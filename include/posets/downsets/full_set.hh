@@ -2,15 +2,28 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <iostream>
-#include <list>
-#include <set>
+#include <limits>
+#include <span>
+#include <unordered_set>
 #include <vector>
 
 #include <posets/concepts.hh>
+#include <posets/utils/flat_set.hh>
+#include <posets/utils/skyline.hh>
+
+// The closure marks the points it has seen in a bitmap over the bounding box
+// of the generators if it has at most this many points, and in a hash set
+// otherwise.
+#ifndef FULL_SET_BITMAP_LIMIT
+# define FULL_SET_BITMAP_LIMIT (1UL << 26)
+#endif
 
 namespace posets::downsets {
+  // A downset stored explicitly, as the set of all the points below its
+  // maximal elements, down to -1 in each component.
   template <Vector V>
   class full_set {
     public:
@@ -26,22 +39,26 @@ namespace posets::downsets {
 
       full_set (std::vector<V>&& elements) noexcept {
         assert (not elements.empty ());
-        for (auto&& e : elements)
-          insert (std::move (e));
+        // Closing the maximal elements is enough.
+        downward_close (utils::skyline (std::move (elements)));
       }
 
       [[nodiscard]] bool contains (const V& v) const {
-        return vector_set.find (v) != vector_set.end ();
+        return vector_set.contains (v);
       }
 
       [[nodiscard]] auto size () const { return vector_set.size (); }
 
+      // The set is explicit.
+      [[nodiscard]] uint64_t closure_size () const { return vector_set.size (); }
+
       bool insert (V&& v) {
-        if (vector_set.insert (std::move (v)).second) {
-          downward_close ();
-          return true;
-        }
-        return false;
+        if (contains (v))
+          return false;
+        std::vector<V> generator;
+        generator.push_back (std::move (v));
+        downward_close (generator);
+        return true;
       }
 
       [[nodiscard]] auto& get_backing_vector () { return vector_set; }
@@ -49,80 +66,147 @@ namespace posets::downsets {
       [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
 
     private:
-      // Extraordinarily wasteful.  This computes the closure by taking
-      // vector_set, then everything at distance 1
-      void downward_close () {
-        auto old_size = vector_set.size ();
-
-        while (true) {
-          std::list<V> newelts;
-          std::vector<typename V::value_type> elcopy (vector_set.front ().size ());
-          elcopy.reserve (V::capacity_for (elcopy.size ()));
-
-          for (auto& el : vector_set) {  // Iterate while making copies.
-            el.to_vector (elcopy);
-            for (size_t i = 0; i < el.size (); ++i)
-              if (elcopy[i] > -1) {
-                elcopy[i]--;
-                V v = V (elcopy);
-                elcopy[i]++;
-                if (vector_set.find (v) == vector_set.end ())
-                  newelts.push_back (std::move (v));
-              }
+      using T = typename V::value_type;
+      static constexpr long bottom = -1;
+
+      // Add the points below the generators that are not yet in the set.
+      // Each generator g spans the box of the points p with
+      // min (g[i], bottom) <= p[i] <= g[i], which is enumerated in
+      // mixed-radix order.  A point is named by its rank in the bounding box
+      // of all the boxes, and only kept the first time it is seen; the
+      // points of the set are marked as seen beforehand.  If the bounding box
+      // is too large for ranks to fit in a word, duplicates are only removed
+      // when the points are added to the set.
+      void downward_close (const std::vector<V>& generators) {
+        const size_t dim = generators.front ().size ();
+        std::vector<T> buf (dim);
+        std::vector<long> lo (dim, bottom), hi (dim, std::numeric_limits<long>::min ());
+        for (const auto& g : generators) {
+          g.to_vector (buf);
+          for (size_t i = 0; i < dim; ++i) {
+            lo[i] = std::min<long> (lo[i], buf[i]);
+            hi[i] = std::max<long> (hi[i], buf[i]);
+          }
+        }
+
+        // strides[i] is the weight of component i in the rank.
+        std::vector<uint64_t> strides (dim);
+        uint64_t volume = 1;
+        bool ranked = true;
+        for (size_t i = 0; i < dim and ranked; ++i) {
+          const auto radix = static_cast<uint64_t> (hi[i] - lo[i] + 1);
+          strides[i] = volume;
+          ranked = volume <= std::numeric_limits<uint64_t>::max () / radix;
+          volume *= radix;
+        }
+
+        std::vector<uint64_t> bitmap;
+        std::unordered_set<uint64_t> hashed;
+        const bool use_bitmap = ranked and volume <= FULL_SET_BITMAP_LIMIT;
+        if (use_bitmap)
+          bitmap.resize ((volume + 63) / 64);
+        // Mark rank as seen, and return whether it was new.
+        auto mark = [&] (uint64_t rank) {
+          if (use_bitmap) {
+            const uint64_t bit = uint64_t {1} << (rank % 64);
+            const bool fresh = not (bitmap[rank / 64] & bit);
+            bitmap[rank / 64] |= bit;
+            return fresh;
+          }
+          return hashed.insert (rank).second;
+        };
+
+        if (ranked)
+          for (const auto& e : vector_set) {
+            e.to_vector (buf);
+            uint64_t rank = 0;
+            bool inside = true;
+            for (size_t i = 0; i < dim and inside; ++i) {
+              inside = lo[i] <= buf[i] and buf[i] <= hi[i];
+              rank += static_cast<uint64_t> (buf[i] - lo[i]) * strides[i];
+            }
+            if (inside)
+              mark (rank);
+          }
+
+        std::vector<V> newelts;
+        std::vector<T> top (dim);
+        for (const auto& g : generators) {
+          g.to_vector (top);
+          uint64_t rank = 0;
+          for (size_t i = 0; i < dim; ++i) {
+            buf[i] = static_cast<T> (std::min<long> (top[i], bottom));
+            rank += static_cast<uint64_t> (buf[i] - lo[i]) * strides[i];
+          }
+
+          while (true) {
+            if (ranked ? mark (rank) : not contains_point (buf))
+              newelts.push_back (V (std::span<const T> (buf)));
+            // Next point of the box: the components that are at their
+            // maximum wrap around, and the next one is incremented.
+            size_t i = 0;
+            for (; i < dim and buf[i] == top[i]; ++i) {
+              const auto low = static_cast<T> (std::min<long> (top[i], bottom));
+              rank -= static_cast<uint64_t> (buf[i] - low) * strides[i];
+              buf[i] = low;
+            }
+            if (i == dim)
+              break;
+            ++buf[i];
+            rank += strides[i];
           }
-          if (newelts.empty ())
-            break;
-          for (auto& el : newelts)
-            vector_set.insert (std::move (el));
         }
+        vector_set.insert (std::move (newelts));
+      }
+
+      [[nodiscard]] bool contains_point (const std::vector<T>& p) const {
+        return vector_set.contains (V (std::span<const T> (p)));
       }
 
     public:
+      // Both sets are closed, and so is their union: only the elements of
+      // other that are not in this set are added, with a linear merge.
       void union_with (const full_set& other) {
-        for (auto&& el : other)
-          vector_set.insert (el.copy ());
-        downward_close ();
+        std::vector<V> elements;
+        auto it = vector_set.begin ();
+        for (const auto& el : other) {
+          it = std::lower_bound (it, vector_set.end (), el);
+          if (it == vector_set.end () or el < *it)
+            elements.push_back (el.copy ());
+        }
+        vector_set.insert (std::move (elements));
       }
 
+      // Both sets are closed, and so is their intersection.  The sets are
+      // sorted the same way, so the intersection is a linear merge,
+      // compacting this set in place.
       void intersect_with (const full_set& other) {
-        std::list<std::reference_wrapper<const V>> intersection;
-        std::set_intersection (vector_set.cbegin (), vector_set.cend (),
-                               other.vector_set.cbegin (), other.vector_set.cend (),
-                               std::inserter (intersection, intersection.begin ()));
-        if (intersection.size () != vector_set.size ()) {
-          vector_set.clear ();
-          for (auto& r : intersection)
-            vector_set.insert (r.get ().copy ());
-        }
-        downward_close ();
+        auto it = other.begin ();
+        vector_set.erase_if ([&] (const V& v) {
+          it = std::lower_bound (it, other.end (), v);
+          return it == other.end () or v < *it;
+        });
       }
 
       template <typename F>
       void apply_inplace (const F& lambda) {
-        std::set<V> new_set;
-        for (auto&& el : vector_set) {
-          auto&& changed_el = lambda (el);
-          new_set.insert (changed_el);
-        }
-        vector_set = std::move (new_set);
+        *this = apply (lambda);
       }
 
       template <typename F>
       full_set apply (const F& lambda) const {
-        full_set res;
+        std::vector<V> elements;
+        elements.reserve (vector_set.size ());
         for (const auto& el : vector_set)
-          res.insert (lambda (el));
-        res.downward_close ();
-        return res;
+          elements.push_back (lambda (el));
+        return full_set (std::move (elements));
       }
 
-      auto begin () { return vector_set.begin (); }
       [[nodiscard]] auto begin () const { return vector_set.begin (); }
-      auto end () { return vector_set.end (); }
       [[nodiscard]] auto end () const { return vector_set.end (); }
 
     private:
-      std::set<V> vector_set;
+      utils::flat_set<V> vector_set;
   };
 
   template <Vector V>
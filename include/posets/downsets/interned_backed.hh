@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include <posets/concepts.hh>
+#include <posets/utils/skyline.hh>
+#include <posets/utils/vector_store.hh>
+
+namespace posets::downsets {
+  // An antichain of ids of a utils::vector_store, which holds the vectors.
+  // The algorithms are those of vector_backed; equal vectors have equal ids,
+  // so that an element that is already present is recognized with an
+  // integer compare, and is never copied.  Downsets built while the same
+  // store is current share their vectors; those that are combined (union,
+  // intersection) must share their store.
+  template <Vector V>
+    requires HashableVector<V>
+  class interned_backed {
+      using store_t = utils::vector_store<V>;
+      using id_t = typename store_t::id_t;
+
+    public:
+      using value_type = V;
+
+      interned_backed (V&& v) : store {store_t::current ()} {
+        ids.push_back (store->intern (std::move (v)));
+      }
+
+      interned_backed (std::vector<V>&& elements) : store {store_t::current ()} {
+        for (auto&& e : utils::skyline (std::move (elements)))
+          ids.push_back (store->intern (std::move (e)));
+        assert (not ids.empty ());
+      }
+
+    private:
+      interned_backed (std::shared_ptr<store_t> store) : store {std::move (store)} {}
+
+    public:
+      interned_backed (const interned_backed&) = delete;
+      interned_backed (interned_backed&& other) noexcept
+        : store {std::move (other.store)},
+          ids {std::move (other.ids)} {
+        other.ids.clear ();
+      }
+
+      interned_backed& operator= (interned_backed&& other) noexcept {
+        if (this != &other) {
+          release_all ();
+          store = std::move (other.store);
+          ids = std::move (other.ids);
+          other.ids.clear ();
+        }
+        return *this;
+      }
+
+      interned_backed& operator= (const interned_backed&) = delete;
+
+      ~interned_backed () { release_all (); }
+
+      bool operator== (const interned_backed& other) = delete;
+
+      [[nodiscard]] bool contains (const V& v) const {
+        if (auto id = store->find (v); id and std::ranges::find (ids, *id) != ids.end ())
+          return true;
+        return std::ranges::any_of (ids, [&] (id_t e) { return v.partial_order (at (e)).leq (); });
+      }
+
+      [[nodiscard]] auto size () const { return ids.size (); }
+
+      bool insert (V&& v) {
+        return insert_with (v, [&] () { return store->intern (std::move (v)); });
+      }
+
+      void union_with (interned_backed&& other) {
+        assert (store == other.store);
+        // The references of other are handed over to this.
+        for (auto id : other.ids)
+          if (not insert_with (at (id), [id] () { return id; }))
+            store->release (id);
+        other.ids.clear ();
+      }
+
+      void intersect_with (const interned_backed& other) {
+        assert (store == other.store);
+        interned_backed intersection (store);
+        std::optional<V> scratch;
+        bool smaller_set = false;
+
+        for (auto x : ids) {
+          bool dominated = false;
+
+          for (auto y : other.ids) {
+            if (x == y) {
+              dominated = true;
+              intersection.insert_with (at (x), [&] () {
+                store->acquire (x);
+                return x;
+              });
+              break;
+            }
+            // The meet is computed in scratch, and only interned if it is
+            // not dominated in the intersection.
+            if constexpr (LatticeVector<V>) {
+              if (not scratch)
+                scratch.emplace (at (x).copy ());
+              V::meet_into (*scratch, at (x), at (y));
+            }
+            else
+              scratch.emplace (at (x).meet (at (y)));
+            if (*scratch == at (x))
+              dominated = true;
+            intersection.insert_with (*scratch, [&] () { return store->intern (*scratch); });
+            if (dominated)
+              break;
+          }
+          // If x wasn't <= an element in other, then x is not in the
+          // intersection, thus the set is updated.
+          smaller_set or_eq not dominated;
+        }
+
+        if (smaller_set)
+          *this = std::move (intersection);
+      }
+
+      template <typename F>
+      interned_backed apply (const F& lambda) const {
+        interned_backed res (store);
+        for (auto id : ids)
+          res.insert (lambda (at (id)));
+        return res;
+      }
+
+      using const_iterator = typename store_t::const_iterator;
+
+      [[nodiscard]] auto begin () const { return const_iterator (store.get (), ids.data ()); }
+      [[nodiscard]] auto end () const {
+        return const_iterator (store.get (), ids.data () + ids.size ());
+      }
+
+      // A view of the elements; clearing a view of a non-const set releases
+      // them.
+      template <bool Mutable>
+      class elements_view {
+          using set_ref = std::conditional_t<Mutable, interned_backed&, const interned_backed&>;
+
+        public:
+          elements_view (set_ref set) : set {set} {}
+          [[nodiscard]] auto begin () const { return set.begin (); }
+          [[nodiscard]] auto end () const { return set.end (); }
+          [[nodiscard]] auto size () const { return set.size (); }
+          void clear ()
+            requires Mutable
+          {
+            set.release_all ();
+          }
+
+        private:
+          set_ref set;
+      };
+
+      [[nodiscard]] auto get_backing_vector () { return elements_view<true> (*this); }
+      [[nodiscard]] auto get_backing_vector () const { return elements_view<false> (*this); }
+
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
+
+      /// The ids of the elements, in the store.
+      [[nodiscard]] const auto& get_ids () const { return ids; }
+
+      [[nodiscard]] const auto& get_store () const { return store; }
+
+    private:
+      [[nodiscard]] const V& at (id_t id) const { return (*store)[id]; }
+
+      // Insert v, unless it is dominated; get_id () is only called if v is
+      // kept, and should return an id of v with a reference for this set.
+      // The elements that v dominates are released.
+      template <typename GetId>
+      bool insert_with (const V& v, GetId&& get_id) {
+        bool must_remove = false;
+
+        // This is like remove_if, but allows breaking.
+        auto result = ids.begin ();
+        for (auto it = result; it != ids.end (); ++it) {
+          auto res = v.partial_order (at (*it));
+          if (not must_remove and res.leq ())  // v is dominated.
+            return false;
+          if (res.geq ()) {
+            must_remove = true;
+            store->release (*it);
+          }
+          else {
+            if (result != it)
+              *result = *it;
+            ++result;
+          }
+        }
+
+        ids.erase (result, ids.end ());
+        ids.push_back (get_id ());
+        return true;
+      }
+
+      void release_all () {
+        for (auto id : ids)
+          store->release (id);
+        ids.clear ();
+      }
+
+      std::shared_ptr<store_t> store;
+      std::vector<id_t> ids;
+  };
+
+  template <Vector V>
+  inline std::ostream& operator<< (std::ostream& os, const interned_backed<V>& f) {
+    for (auto&& el : f)
+      os << el << std::endl;
+
+    return os;
+  }
+}
@@ -1,14 +1,27 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <set>
 #include <vector>
 
 #include <posets/concepts.hh>
 #include <posets/utils/kdtree.hh>
+#include <posets/utils/skyline.hh>
+#include <posets/utils/thread_pool.hh>
+
+// union_with inserts the elements of the other set one by one if this set is
+// at least this many times larger, and rebuilds the tree otherwise.
+#ifndef KDTREE_UNION_INSERT_RATIO
+# define KDTREE_UNION_INSERT_RATIO 4UL
+#endif
 
 namespace posets::downsets {
   // Forward definition for the operator<<s.
@@ -36,45 +49,25 @@ namespace posets::downsets {
           V&& operator() (V*&& pv) { return std::move (*pv); }
       };
 
+      // With several threads, a large list of elements is first filtered by
+      // dropping, in parallel, the elements that are strictly dominated by
+      // another; the skyline then only has the duplicates to remove.
       void reset_tree (std::vector<V>&& elements) noexcept {
-        std::vector<V*> pelements;
-        pelements.reserve (elements.size ());
-        for (auto& e : elements)
-          pelements.push_back (&e);
-
-        std::sort (pelements.begin (), pelements.end (),
-                   // A strict total order.
-                   [] (const V* v1, const V* v2) {
-                     // A quite costly thing to do.
-                     for (size_t i = 0; i < v1->size (); ++i) {
-                       if ((*v1)[i] > (*v2)[i])
-                         return false;
-                       if ((*v1)[i] < (*v2)[i])
-                         return true;
-                     }
-                     // Equal MUST return false.
-                     return false;
-                   });
-
-        // then remove duplicates
-        size_t dups_pos = pelements.size ();
-        for (size_t i = pelements.size () - 1; i > 0; --i)
-          if (*pelements[i] == *pelements[i - 1])
-            std::swap (pelements[i], pelements[--dups_pos]);
-        if (dups_pos != pelements.size ())
-          pelements.erase (pelements.begin () + dups_pos, pelements.end ());
-
-        // now, we can make a tree out of the set to eliminate dominated
-        // elements
-        auto antichain = std::vector<V*> ();
-        antichain.reserve (pelements.size ());
-        this->tree.relabel_tree (std::move (pelements), proj ());
-
-        for (V& e : this->tree)
-          if (not this->tree.dominates (e, true))
-            antichain.push_back (&e);
-
-        this->tree.relabel_tree (std::move (antichain), proj ());
+        auto& pool = utils::thread_pool::global ();
+        if (pool.size () > 1 and elements.size () >= KDTREE_PARALLEL_CUTOFF) {
+          utils::kdtree<V> candidates (std::move (elements));
+          auto& backing = candidates.get_backing_vector ();
+          std::vector<char> dominated (backing.size ());
+          pool.for_chunks (backing.size (), 256, [&] (size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+              dominated[i] = candidates.dominates (backing[i], true);
+          });
+          elements.clear ();
+          for (size_t i = 0; i < backing.size (); ++i)
+            if (not dominated[i])
+              elements.push_back (std::move (backing[i]));
+        }
+        this->tree.relabel_tree (utils::skyline (std::move (elements)));
         assert (this->tree.is_antichain ());
       }
 
@@ -106,9 +99,26 @@ namespace posets::downsets {
 
       [[nodiscard]] bool contains (const V& v) const { return this->tree.dominates (v); }
 
+      /// Insert v, unless it is dominated; the elements that v dominates are
+      /// removed.  The tree is updated incrementally.
+      bool insert (V&& v) {
+        if (this->tree.dominates (v))
+          return false;
+        this->tree.erase_dominated (v);
+        this->tree.insert (std::move (v));
+        return true;
+      }
+
       // Union in place
       void union_with (kdtree_backed&& other) {
         assert (other.size () > 0);
+        if (other.size () * KDTREE_UNION_INSERT_RATIO <= this->size ()) {
+          for (auto& e : other.tree)
+            insert (std::move (e));
+          assert (this->tree.is_antichain ());
+          return;
+        }
+
         std::vector<V*> result;
         result.reserve (this->size () + other.size ());
         // for all elements in this tree, if they are not strictly
@@ -129,36 +139,54 @@ namespace posets::downsets {
         assert (this->tree.is_antichain ());
       }
 
-      // Intersection in place
+      // Intersection in place.  The elements x of this tree are handled in
+      // parallel if there are enough meets to compute: each x gets its own
+      // list of meets, and the lists are concatenated in the order of the
+      // elements, so that the result does not depend on the scheduling.
       void intersect_with (const kdtree_backed& other) {
-        std::vector<V> intersection;
-        bool smaller_set = false;
-
-        for (auto& x : tree) {
-          assert (x.size () > 0);
-
-          // If x is part of the set of all meets, then x will dominate the
-          // whole list! So we use this to short-circuit the computation: we
-          // first check whether x will be there (which happens only if it is
-          // itself dominated by some element in other)
-          const bool dominated = other.tree.dominates (x);
-          if (dominated)
-            intersection.push_back (x.copy ());
-          else
-            for (auto& y : other)
-              intersection.push_back (x.meet (y));
-
-          // If x wasn't in the set of meets, dominated is false and
-          // the set of minima is different than what is in this->tree
-          smaller_set or_eq not dominated;
-        }
-
-        // We can skip building trees and all if this->tree is the antichain
-        // of minimal elements
-        if (not smaller_set)
+        const auto& elements = this->tree.get_backing_vector ();
+        std::vector<std::vector<V>> meets (elements.size ());
+        std::vector<char> dominated (elements.size ());
+
+        auto intersect_range = [&] (size_t begin, size_t end) {
+          std::optional<V> scratch;
+          for (size_t i = begin; i < end; ++i) {
+            const auto& x = elements[i];
+            assert (x.size () > 0);
+
+            // If x is part of the set of all meets, then x will dominate the
+            // whole list! So we use this to short-circuit the computation: we
+            // first check whether x will be there (which happens only if it
+            // is itself dominated by some element in other)
+            dominated[i] = other.tree.dominates (x);
+            if (not dominated[i])
+              utils::append_meets (x, other, meets[i], scratch);
+          }
+        };
+        if (elements.size () * other.size () >= KDTREE_PARALLEL_CUTOFF)
+          utils::thread_pool::global ().for_chunks (
+              elements.size (), std::max (1UL, KDTREE_PARALLEL_CUTOFF / other.size ()),
+              intersect_range);
+        else
+          intersect_range (0, elements.size ());
+
+        // If some x wasn't in the set of meets, the set of minima is
+        // different than what is in this->tree; otherwise, we can skip
+        // building trees and all
+        if (std::ranges::all_of (dominated, std::identity ()))
           return;
 
         // Worst-case scenario: we do need to build trees
+        std::vector<V> intersection;
+        size_t total = 0;
+        for (size_t i = 0; i < elements.size (); ++i)
+          total += dominated[i] ? 1 : meets[i].size ();
+        intersection.reserve (total);
+        for (size_t i = 0; i < elements.size (); ++i)
+          if (dominated[i])
+            intersection.push_back (elements[i].copy ());
+          else
+            std::ranges::move (meets[i], std::back_inserter (intersection));
         reset_tree (std::move (intersection));
       }
 
@@ -168,6 +196,10 @@ namespace posets::downsets {
 
       [[nodiscard]] const auto& get_backing_vector () const { return tree.get_backing_vector (); }
 
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
+
       [[nodiscard]] auto begin () { return this->tree.begin (); }
       [[nodiscard]] auto begin () const { return this->tree.begin (); }
       [[nodiscard]] auto end () { return this->tree.end (); }
@@ -2,12 +2,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
-#include <set>
+#include <optional>
 #include <vector>
 
 #include <posets/concepts.hh>
-#include <posets/utils/ref_ptr_cmp.hh>
+#include <posets/utils/flat_set.hh>
+#include <posets/utils/skyline.hh>
 
 namespace posets::downsets {
   template <Vector V>
@@ -19,10 +21,8 @@ namespace posets::downsets {
       set_backed () = default;
 
     public:
-      set_backed (std::vector<V>&& elements) {
-        for (auto&& v : elements)
-          insert (std::move (v));
-      }
+      set_backed (std::vector<V>&& elements)
+        : vector_set {utils::skyline (std::move (elements))} {}
 
       set_backed (V&& v) noexcept { insert (std::move (v)); }
 
@@ -30,77 +30,62 @@ namespace posets::downsets {
       set_backed (set_backed&&) = default;
       set_backed& operator= (set_backed&&) = default;
 
-      [[nodiscard]] bool contains (const V& v) const {
-        for (const auto& e : vector_set)
-          if (v.partial_order (e).leq ())
-            return true;
-        return false;
-      }
+      [[nodiscard]] bool contains (const V& v) const { return dominates (v); }
 
       [[nodiscard]] auto size () const { return vector_set.size (); }
 
       bool insert (V&& v) {
-        utils::reference_wrapper_set<const V> to_remove;
-        bool should_be_inserted = true;
-
-        for (const auto& e : vector_set) {
-          auto po = v.partial_order (e);
-          if (po.leq ()) {
-            should_be_inserted = false;
-            break;
-          }
+        // Since the set is an antichain, v can't both dominate an element
+        // and be dominated by another.  So once an element dominated by v is
+        // found, the rest of the set is compacted in one pass.
+        for (auto it = vector_set.begin (); it != vector_set.end (); ++it) {
+          auto po = v.partial_order (*it);
+          if (po.leq ())
+            return false;
           if (po.geq ()) {
-            should_be_inserted = true;
-            to_remove.insert (std::cref (e));
+            vector_set.erase_if ([&v] (const V& e) { return v.partial_order (e).geq (); }, it);
+            break;
           }
         }
 
-        for (const auto& elt : to_remove)
-          vector_set.erase (elt.get ());
-
-        if (should_be_inserted)
-          vector_set.insert (std::move (v));
-
-        return should_be_inserted;
+        vector_set.insert (std::move (v));
+        return true;
       }
 
       void union_with (set_backed&& other) {
-        for (auto it = other.begin (); it != other.end (); /* in-body */)
-          insert (std::move (other.vector_set.extract (it++).value ()));
+        std::vector<V> result;
+        // Only drop the elements of this set that are strictly dominated, so
+        // that elements in both sets are kept once.
+        vector_set.erase_if ([&other] (const V& e) { return other.dominates (e, true); });
+        for (auto&& e : std::move (other.vector_set).extract ())
+          if (not dominates (e))
+            result.push_back (std::move (e));
+        vector_set.insert (std::move (result));
       }
 
       void intersect_with (const set_backed& other) {
-        set_backed intersection;
+        std::vector<V> intersection;
+        std::optional<V> scratch;
         bool smaller_set = false;
 
         for (const auto& x : vector_set) {
-          bool dominated = false;
-
-          for (const auto& y : other.vector_set) {
-            V&& v = x.meet (y);
-            if (v == x)
-              dominated = true;
-            intersection.insert (std::move (v));
-            if (dominated)
-              break;
+          // If x is <= an element in other, it dominates all its meets.
+          if (other.dominates (x)) {
+            intersection.push_back (x.copy ());
+            continue;
           }
-          // If x wasn't <= an element in other, then x is not in the
-          // intersection, thus the set is updated.
-          smaller_set or_eq not dominated;
+          // Otherwise x is not in the intersection, thus the set is updated.
+          smaller_set = true;
+          utils::append_meets (x, other.vector_set, intersection, scratch);
         }
 
         if (smaller_set)
-          this->vector_set = std::move (intersection.vector_set);
+          this->vector_set = utils::flat_set<V> (utils::skyline (std::move (intersection)));
       }
 
       template <typename F>
       void apply_inplace (const F& lambda) {
-        std::set<V> new_set;
-        for (auto&& el : vector_set) {
-          auto&& changed_el = lambda (el);
-          new_set.insert (changed_el);
-        }
-        vector_set = std::move (new_set);
+        *this = apply (lambda);
       }
 
       template <typename F>
@@ -115,13 +100,25 @@ namespace posets::downsets {
 
       [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
 
-      [[nodiscard]] auto begin () { return vector_set.begin (); }
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
+
       [[nodiscard]] auto begin () const { return vector_set.begin (); }
-      [[nodiscard]] auto end () { return vector_set.end (); }
       [[nodiscard]] auto end () const { return vector_set.end (); }
 
     private:
-      std::set<V> vector_set;
+      // Whether some element is >= v (strictly if strict is set).
+      [[nodiscard]] bool dominates (const V& v, bool strict = false) const {
+        for (const auto& e : vector_set) {
+          auto po = v.partial_order (e);
+          if (po.leq () and not (strict and po.geq ()))
+            return true;
+        }
+        return false;
+      }
+
+      utils::flat_set<V> vector_set;
   };
 
   template <Vector V>
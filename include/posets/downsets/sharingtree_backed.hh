@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <set>
@@ -9,6 +10,7 @@
 
 #include <posets/concepts.hh>
 #include <posets/utils/sharingforest.hh>
+#include <posets/utils/skyline.hh>
 
 namespace posets::downsets {
 
@@ -52,7 +54,7 @@ namespace posets::downsets {
 
       sharingtree_backed (std::vector<V>&& elements) noexcept {
         init_forest (elements.begin ()->size ());
-        this->root = this->forest->add_vectors (std::move (elements));
+        this->root = this->forest->add_vectors (utils::skyline (std::move (elements)));
         this->vector_set = this->forest->get_all (this->root);
       }
 
@@ -70,6 +72,11 @@ namespace posets::downsets {
       [[nodiscard]] auto& get_backing_vector () { return vector_set; }
       [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
 
+      // Counted over the DAG of the forest, see utils::sharingforest::closure_size.
+      [[nodiscard]] uint64_t closure_size () const {
+        return this->forest->closure_size (this->root);
+      }
+
       [[nodiscard]] bool contains (const V& v) const {
         return this->forest->covers_vector (this->root, v);
       }
@@ -2,13 +2,16 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <set>
 #include <vector>
 
 #include <posets/concepts.hh>
 #include <posets/utils/sharingtrie.hh>
+#include <posets/utils/skyline.hh>
 
 namespace posets::downsets {
   // Forward definition for the operator<<s.
@@ -33,25 +36,7 @@ namespace posets::downsets {
       };
 
       void reset_trie (std::vector<V>&& elements) noexcept {
-        std::vector<V*> pelements;
-        pelements.reserve (elements.size ());
-        for (auto& e : elements)
-          pelements.push_back (&e);
-
-        // now, we can make a trie out of the set to eliminate dominated
-        // elements
-        auto antichain = std::vector<V*> ();
-        antichain.reserve (pelements.size ());
-        this->trie.relabel_trie (std::move (pelements), proj ());
-
-        // Get all will produce vectors represented by the trie, this will
-        // avoid possibly repeated ones in elements!
-        std::vector<V> repd = this->trie.get_all ();
-        for (auto& e : repd)
-          if (not this->trie.dominates (e, true))
-            antichain.push_back (&e);
-
-        this->trie.relabel_trie (std::move (antichain), proj ());
+        this->trie.relabel_trie (utils::skyline (std::move (elements)));
         assert (this->trie.is_antichain ());
       }
 
@@ -111,6 +96,7 @@ namespace posets::downsets {
       // Intersection in place
       void intersect_with (const sharingtrie_backed& other) {
         std::vector<V> intersection;
+        std::optional<V> scratch;
         bool smaller_set = false;
 
         for (auto& x : trie) {
@@ -124,8 +110,7 @@ namespace posets::downsets {
           if (dominated)
             intersection.push_back (x.copy ());
           else
-            for (auto& y : other)
-              intersection.push_back (x.meet (y));
+            utils::append_meets (x, other, intersection, scratch);
 
           // If x wasn't in the set of meets, dominated is false and
           // the set of minima is different than what is in this->trie
@@ -147,6 +132,10 @@ namespace posets::downsets {
 
       [[nodiscard]] const auto& get_backing_vector () const { return trie.get_backing_vector (); }
 
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
+
       [[nodiscard]] auto begin () { return this->trie.begin (); }
       [[nodiscard]] auto begin () const { return this->trie.begin (); }
       [[nodiscard]] auto end () { return this->trie.end (); }
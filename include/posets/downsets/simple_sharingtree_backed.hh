@@ -2,13 +2,16 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <set>
 #include <vector>
 
 #include <posets/concepts.hh>
 #include <posets/utils/sharingforest.hh>
+#include <posets/utils/skyline.hh>
 
 namespace posets::downsets {
 
@@ -41,26 +44,15 @@ namespace posets::downsets {
         }
       }
 
-      // Code borrowed from kdtree_backed, same idea as there
-      // to keep the antichain of max elements only
+      // Keep the antichain of max elements only, and share them in the forest
       void reset_tree (std::vector<V>&& elements) noexcept {
-        const size_t temp_tree = this->forest->add_vectors (std::move (elements), false);
-        this->vector_set = this->forest->get_all (temp_tree);
+        this->vector_set = utils::skyline (std::move (elements));
 
-        // we can use the temporary tree to eliminate dominated elements
         std::vector<V> antichain;
-        std::vector<V> result;
         antichain.reserve (this->vector_set.size ());
-        result.reserve (this->vector_set.size ());
-        for (auto& e : this->vector_set) {
-          if (not this->forest->covers_vector (temp_tree, e, true)) {
-            antichain.push_back (e.copy ());
-            result.push_back (std::move (e));
-          }
-        }
-
+        for (const auto& e : this->vector_set)
+          antichain.push_back (e.copy ());
         this->root = this->forest->add_vectors (std::move (antichain), false);
-        this->vector_set = std::move (result);
       }
 
       [[nodiscard]] bool is_antichain () const {
@@ -103,6 +95,10 @@ namespace posets::downsets {
       [[nodiscard]] auto& get_backing_vector () { return vector_set; }
       [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
 
+      [[nodiscard]] uint64_t closure_size () const {
+        return this->forest->closure_size (this->root);
+      }
+
       [[nodiscard]] bool contains (const V& v) const {
         return this->forest->covers_vector (this->root, v);
       }
@@ -145,6 +141,7 @@ namespace posets::downsets {
       // Intersection in place
       void intersect_with (const simple_sharingtree_backed& other) {
         std::vector<V> intersection;
+        std::optional<V> scratch;
         bool smaller_set = false;
 
         for (const auto& x : this->vector_set) {
@@ -158,8 +155,7 @@ namespace posets::downsets {
           if (dominated)
             intersection.push_back (x.copy ());
           else
-            for (auto& y : other)
-              intersection.push_back (x.meet (y));
+            utils::append_meets (x, other, intersection, scratch);
 
           // If x wasn't in the set of meets, dominated is false and
           // the set of minima is different than what is in this->tree
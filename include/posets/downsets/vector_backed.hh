@@ -2,10 +2,13 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <optional>
 #include <vector>
 
 #include <posets/concepts.hh>
+#include <posets/utils/skyline.hh>
 
 namespace posets::downsets {
   // A forward definition to allow for friend status
@@ -19,10 +22,9 @@ namespace posets::downsets {
 
       vector_backed (V&& v) { insert (std::move (v)); }
 
-      vector_backed (std::vector<V>&& elements) noexcept {
-        assert (not elements.empty ());
-        for (auto&& e : elements)
-          insert (std::move (e));
+      vector_backed (std::vector<V>&& elements) noexcept
+        : vector_set {utils::skyline (std::move (elements))} {
+        assert (not vector_set.empty ());
       }
 
     private:
@@ -44,36 +46,7 @@ namespace posets::downsets {
 
       [[nodiscard]] auto size () const { return vector_set.size (); }
 
-      bool insert (V&& v) {
-        bool must_remove = false;
-
-        // This is like remove_if, but allows breaking.
-        auto result = vector_set.begin ();
-        auto end = vector_set.end ();
-
-        for (auto it = result; it != end; ++it) {
-          auto res = v.partial_order (*it);
-          if (not must_remove and res.leq ()) {  // v is dominated.
-            // if must_remove is true, since we started with an antichain,
-            // it's not possible that res.leq () holds.  Hence we don't check for
-            // leq if must_remove is true.
-            return false;
-          }
-          if (res.geq ()) {     // v dominates *it
-            must_remove = true; /* *it should be removed */
-          }
-          else {               // *it needs to be kept
-            if (result != it)  // This can be false only on the first element.
-              *result = std::move (*it);
-            ++result;
-          }
-        }
-
-        if (result != vector_set.end ())
-          vector_set.erase (result, vector_set.end ());
-        vector_set.push_back (std::move (v));
-        return true;
-      }
+      bool insert (V&& v) { return utils::antichain_insert (vector_set, 0, v); }
 
       void union_with (vector_backed&& other) {
         for (auto&& e : other.vector_set)
@@ -82,16 +55,26 @@ namespace posets::downsets {
 
       void intersect_with (const vector_backed& other) {
         vector_backed intersection;
+        std::optional<V> scratch;
         bool smaller_set = false;
 
         for (const auto& x : vector_set) {
           bool dominated = false;
 
           for (auto& y : other.vector_set) {
-            V v = x.meet (y);
-            if (v == x)
+            // The meet is computed in scratch, which is only moved into the
+            // intersection if it is not dominated there.
+            if constexpr (LatticeVector<V>) {
+              if (not scratch)
+                scratch.emplace (x.copy ());
+              V::meet_into (*scratch, x, y);
+            }
+            else
+              scratch.emplace (x.meet (y));
+            if (*scratch == x)
               dominated = true;
-            intersection.insert (std::move (v));
+            if (utils::antichain_insert (intersection.vector_set, 0, *scratch))
+              scratch.reset ();
             if (dominated)
               break;
           };
@@ -118,6 +101,10 @@ namespace posets::downsets {
       [[nodiscard]] auto& get_backing_vector () { return vector_set; }
       [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
 
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
+
       template <Vector V2>
       friend class vector_or_kdtree_backed;
   };
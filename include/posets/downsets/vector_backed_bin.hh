@@ -2,35 +2,51 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
-#include <set>
-#include <sstream>
+#include <optional>
 #include <vector>
 
 #include <posets/concepts.hh>
+#include <posets/utils/columnar.hh>
+#include <posets/utils/skyline.hh>
+#include <posets/utils/thread_pool.hh>
 #include <posets/vectors/traits.hh>
 
+// The bins of this set are intersected in parallel if the product of the
+// sizes of the sets is at least this.
+#ifndef VECTOR_BIN_PARALLEL_CUTOFF
+# define VECTOR_BIN_PARALLEL_CUTOFF (1UL << 13)
+#endif
+
 namespace posets::downsets {
+  // An antichain whose elements are grouped by bin, where the bin of a
+  // vector is a number that can only grow when going up in the order (e.g.,
+  // the sum of the components).  Only the bins at or above bin_of (v) can
+  // contain an element that dominates v, and only those at or below it an
+  // element that v dominates.  Each bin is stored transposed, see
+  // utils::columnar, so that it is scanned one SIMD block of elements at a
+  // time; the elements themselves are kept in a vector, in no particular
+  // order.
   template <Vector V>
   class vector_backed_bin {
+      using columns_t = utils::columnar<typename V::value_type>;
+      using lane_mask = typename columns_t::lane_mask;
+      static constexpr auto lanes = columns_t::lanes;
+
     public:
       using value_type = V;
 
-      vector_backed_bin (V&& v) {
-        bins.resize (v.size ());
-        insert (std::move (v));
-      }
+      vector_backed_bin (V&& v) : dim {v.size ()} { insert (std::move (v)); }
 
-      vector_backed_bin (std::vector<V>&& elements) noexcept {
-        assert (not elements.empty ());
-        bins.resize (elements[0].size ());
-        for (auto&& e : elements)
-          insert (std::move (e));
+      vector_backed_bin (std::vector<V>&& elements) noexcept : dim {elements.at (0).size ()} {
+        for (auto&& e : utils::skyline (std::move (elements)))
+          insert (std::move (e), false);
       }
 
     private:
-      vector_backed_bin (size_t starting_bins_size) { bins.resize (starting_bins_size); }
+      vector_backed_bin (size_t dim, size_t nbins) : dim {dim} { bins.reserve (nbins); }
 
     public:
       vector_backed_bin (const vector_backed_bin&) = delete;
@@ -40,145 +56,124 @@ namespace posets::downsets {
 
       bool operator== (const vector_backed_bin& other) = delete;
 
-      [[nodiscard]] bool contains (const V& v) const {
-        const size_t bin = bin_of (v);
-
-        if (bin >= bins.size ())
-          return false;
-        for (auto it = bins.begin () + bin; it != bins.end (); ++it)
-          for (const auto& e : *it)
-            if (v.partial_order (*e).leq ())
-              return true;
-        return false;
-      }
+      [[nodiscard]] bool contains (const V& v) const { return dominates (v); }
 
-      [[nodiscard]] auto size () const { return all_vs.size (); }
+      [[nodiscard]] auto size () const { return vector_set.size (); }
 
       bool insert (V&& v, bool antichain = true) {
         const size_t bin = bin_of (v);
 
         if (antichain) {
-          auto start = std::min (bin, bins.size () - 1);
-          [[maybe_unused]] bool must_remove = false;
-
-          size_t i = start;
-          do {
-            // This is like remove_if, but allows breaking.
-            auto result = bins[i].begin ();
-            auto end = bins[i].end ();
-
-            for (auto it = result; it != end; ++it) {
-              auto res = v.partial_order (**it);
-              if (not must_remove and res.leq ()) {  // v is dominated.
-                // if must_remove is true, since we started with an antichain,
-                // it's not possible that res.leq () holds.  Hence we don't check for
-                // leq if must_remove is true.
-                return false;
-              }
-              if (res.geq ()) {     // v dominates *it
-                must_remove = true; /* *it should be removed */
-                all_vs.erase (*it);
-                // do not increase result (so that it will be erased later).
-              }
-              else {               // *it needs to be kept
-                if (result != it)  // This can be false only on the first element.
-                  *result = std::move (*it);
-                ++result;
-              }
-            }
-
-            if (result != bins[i].end ())
-              bins[i].erase (result, bins[i].end ());
-
-            i = (i + 1) % bins.size ();
-          } while (i != start);
+          if (dominates (v))
+            return false;
+          // Since we started with an antichain and v is not dominated, the
+          // elements that v dominates are strictly dominated.
+          for (size_t b = 0; b < std::min (bin + 1, bins.size ()); ++b)
+            erase_dominated (b, v);
         }
 
-        if (bin >= bins.size ())
-          bins.resize (bin + 1);
-        all_vs.push_front (std::move (v));
-        bins[bin].push_back (all_vs.begin ());
+        while (bins.size () <= bin)
+          bins.push_back (bin_t {columns_t (dim), {}});
+        auto& into = bins[bin];
+        where.push_back ({bin, into.ids.size ()});
+        into.columns.push_back (v);
+        into.ids.push_back (vector_set.size ());
+        vector_set.push_back (std::move (v));
         return true;
       }
 
+      // Union in place.  Both sets are filtered against the other, then the
+      // survivors are binned anew.
       void union_with (vector_backed_bin&& other) {
-        for (auto&& v : other.all_vs)
-          insert (std::move (v));
+        std::vector<V> result;
+        result.reserve (size () + other.size ());
+        // An element of this set is only dropped if it is strictly dominated,
+        // so that elements in both sets are kept once.
+        for (auto& e : vector_set)
+          if (not other.dominates (e, true))
+            result.push_back (std::move (e));
+        for (auto& e : other.vector_set)
+          if (not dominates (e))
+            result.push_back (std::move (e));
+
+        clear ();
+        for (auto&& e : result)
+          insert (std::move (e), false);
       }
 
-      void intersect_with (vector_backed_bin&& other) {
-        if (bins.empty ())
-          return;
-        vector_backed_bin intersection (bins.size ());
-
-        size_t bin = bins.size () / 2;
-
-        do {
-          for (auto& x : bins[bin]) {
-            bool dominated = false;
-
-            // These can dominate x
-            for (size_t i = bin; i < other.bins.size (); ++i) {
-              for (auto& el : other.bins[i]) {
-                V&& v = x->meet (*el);
-                if (v == *x)
-                  dominated = true;
-                // TODO ("Check v == el too?  See if this is good tradeoff.");
-                intersection.insert (std::move (v));
-                if (dominated)
-                  break;
-              }
-              if (dominated)
-                break;
-            }
-            if (dominated)
-              continue;
-
-            // These cannot dominate x
-            for (ssize_t i = std::min (bin, other.bins.size () - 1); i >= 0; --i) {
-              for (auto it = other.bins[i].begin (); it != other.bins[i].end ();
-                   /* in-body */) {
-                V&& v = x->meet (**it);
-                if (v == **it) {
-                  intersection.insert (std::move (v));
-                  if (it != other.bins[i].end () - 1)
-                    std::swap (*it, other.bins[i].back ());
-                  other.bins[i].pop_back ();
-                }
-                else {
-                  intersection.insert (std::move (v));
-                  ++it;
-                }
-              }
+      // Intersection in place.  The bins of this set are handled in
+      // parallel if there are enough meets to compute; each bin gets its own
+      // list of meets, and the lists are concatenated in the order of the
+      // bins, so that the result does not depend on the scheduling.
+      void intersect_with (const vector_backed_bin& other) {
+        std::vector<std::vector<V>> meets (bins.size ());
+        std::vector<char> changed (bins.size ());
+
+        auto intersect_bin = [&] (size_t b) {
+          std::optional<V> scratch;
+          for (auto id : bins[b].ids) {
+            const auto& x = vector_set[id];
+            // If x is dominated by other, it dominates all of its meets.
+            if (other.dominates (x))
+              meets[b].push_back (x.copy ());
+            else {
+              changed[b] = true;
+              utils::append_meets (x, other.vector_set, meets[b], scratch);
             }
           }
-          bin = (bin == bins.size () - 1 ? 0 : bin + 1);
-        } while (bin != bins.size () / 2);
+        };
+        if (size () * other.size () >= VECTOR_BIN_PARALLEL_CUTOFF)
+          utils::thread_pool::global ().run (bins.size (), intersect_bin);
+        else
+          for (size_t b = 0; b < bins.size (); ++b)
+            intersect_bin (b);
+
+        if (std::ranges::none_of (changed, std::identity ()))
+          return;
 
-        *this = std::move (intersection);
+        std::vector<V> intersection;
+        for (auto& m : meets)
+          std::ranges::move (m, std::back_inserter (intersection));
+        *this = vector_backed_bin (std::move (intersection));
       }
 
       template <typename F>
       vector_backed_bin apply (const F& lambda) const {
-        vector_backed_bin res (bins.size ());
-        for (auto& el : all_vs)
+        vector_backed_bin res (dim, bins.size ());
+        for (const auto& el : vector_set)
           res.insert (lambda (el));
 
         return res;
       }
 
-      [[nodiscard]] auto& get_backing_vector () { return all_vs; }
+      // Note that the bins are not updated if the backing vector is
+      // modified; this is meant for moving the elements out.
+      [[nodiscard]] auto& get_backing_vector () { return vector_set; }
+
+      [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
 
-      [[nodiscard]] const auto& get_backing_vector () const { return all_vs; }
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
 
-      [[nodiscard]] auto begin () const { return all_vs.begin (); }
+      [[nodiscard]] auto begin () const { return vector_set.begin (); }
 
-      [[nodiscard]] auto end () const { return all_vs.end (); }
+      [[nodiscard]] auto end () const { return vector_set.end (); }
 
     private:
-      std::list<V> all_vs;
-      using bins_t = std::vector<std::vector<typename decltype (all_vs)::iterator>>;
-      bins_t bins;  // [n] -> all the vectors with v.bin() = n
+      struct bin_t {
+          columns_t columns;
+          std::vector<size_t> ids;  // ids[r] is the index in vector_set of row r.
+      };
+
+      size_t dim;
+      std::vector<V> vector_set;
+      std::vector<bin_t> bins;  // [n] -> all the vectors with bin_of (v) = n
+      // where[i] is the bin of vector_set[i], and its row in that bin.
+      std::vector<std::pair<size_t, size_t>> where;
+      // Scratch space for erase_dominated.
+      std::vector<lane_mask> removed;
+      std::vector<size_t> removed_ids;
 
       // Surely: if bin_of (u) > bin_of (v), then v can't dominate u.
       [[nodiscard]] size_t bin_of (const V& v) const {
@@ -186,6 +181,64 @@ namespace posets::downsets {
           return v.bin ();
         return 0;
       }
+
+      // Whether some element is >= v (strictly if strict is set).
+      [[nodiscard]] bool dominates (const V& v, bool strict = false) const {
+        for (size_t b = bin_of (v); b < bins.size (); ++b)
+          if (bins[b].columns.any_geq (v, strict))
+            return true;
+        return false;
+      }
+
+      // Remove the elements of bin b that are <= v.
+      void erase_dominated (size_t b, const V& v) {
+        auto& bin = bins[b];
+        const size_t nblocks = bin.columns.nblocks ();
+        removed.assign (nblocks, 0);
+        bool any = false;
+        for (size_t k = 0; k < nblocks; ++k) {
+          bin.columns.compare_block (k, v, nullptr, &removed[k]);
+          any or_eq (removed[k] != 0);
+        }
+        if (not any)
+          return;
+
+        bin.columns.erase (removed);
+        removed_ids.clear ();
+        size_t kept = 0;
+        for (size_t r = 0; r < bin.ids.size (); ++r)
+          if (removed[r / lanes] & (lane_mask {1} << (r % lanes)))
+            removed_ids.push_back (bin.ids[r]);
+          else {
+            bin.ids[kept] = bin.ids[r];
+            where[bin.ids[kept]].second = kept;
+            ++kept;
+          }
+        bin.ids.resize (kept);
+
+        // Fill the holes in vector_set with its last elements, from the
+        // back, so that a moved element is never one that is removed.
+        std::ranges::sort (removed_ids, std::greater<> ());
+        for (auto id : removed_ids) {
+          const size_t last = vector_set.size () - 1;
+          if (id != last) {
+            vector_set[id] = std::move (vector_set[last]);
+            where[id] = where[last];
+            bins[where[id].first].ids[where[id].second] = id;
+          }
+          vector_set.pop_back ();
+          where.pop_back ();
+        }
+      }
+
+      void clear () {
+        vector_set.clear ();
+        where.clear ();
+        for (auto& bin : bins) {
+          bin.columns.clear ();
+          bin.ids.clear ();
+        }
+      }
   };
 
   template <Vector V>
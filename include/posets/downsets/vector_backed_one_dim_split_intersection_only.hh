@@ -2,11 +2,13 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <set>
 #include <vector>
 
 #include <posets/concepts.hh>
+#include <posets/utils/skyline.hh>
 #include <posets/utils/vector_mm.hh>
 
 namespace posets::downsets {
@@ -19,10 +21,9 @@ namespace posets::downsets {
 
       vector_backed_one_dim_split_intersection_only (V&& v) { insert (std::move (v)); }
 
-      vector_backed_one_dim_split_intersection_only (std::vector<V>&& elements) noexcept {
-        assert (not elements.empty ());
-        for (auto&& e : elements)
-          insert (std::move (e));
+      vector_backed_one_dim_split_intersection_only (std::vector<V>&& elements) noexcept
+        : vector_set {utils::skyline (std::move (elements))} {
+        assert (not vector_set.empty ());
       }
 
     private:
@@ -164,6 +165,10 @@ namespace posets::downsets {
 
       [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
 
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
+
       [[nodiscard]] auto begin () { return vector_set.begin (); }
       [[nodiscard]] auto begin () const { return vector_set.begin (); }
       [[nodiscard]] auto end () { return vector_set.end (); }
@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -91,7 +92,7 @@ namespace posets::downsets {
           }
           else {
             m = this->size ();
-            n = this->size ();
+            n = other.size ();
           }
           if (static_cast<double> (n) < exp (static_cast<double> (m))) {
             if (inter)
@@ -205,6 +206,10 @@ namespace posets::downsets {
         return vector ? vector->get_backing_vector () : kdtree->get_backing_vector ();
       }
 
+      [[nodiscard]] uint64_t closure_size () const {
+        return utils::closure_size (get_backing_vector ());
+      }
+
       [[nodiscard]] auto begin () {
         return this->kdtree != nullptr ? this->kdtree->begin () : this->vector->begin ();
       }
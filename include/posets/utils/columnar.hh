@@ -0,0 +1,163 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <experimental/simd>
+#include <vector>
+
+#include <posets/utils/simd_traits.hh>
+#include <posets/utils/vector_mm.hh>
+
+namespace posets::utils {
+  // A transposed (structure-of-arrays) store of vectors: component d of all
+  // the rows is stored contiguously, so that one query vector can be compared
+  // against simd_size rows with a single SIMD instruction per dimension.  The
+  // rows are grouped in blocks of simd_size lanes, and comparison results are
+  // returned as lane masks (bit i set iff row block * lanes + i matches).
+  template <typename T>
+  class columnar {
+    public:
+      using simd = typename simd_traits<T>::fssimd;
+      using lane_mask = uint64_t;
+
+      static constexpr size_t lanes = simd_traits<T>::simd_size;
+      static_assert (lanes <= sizeof (lane_mask) * 8, "Lane masks would not fit in a word.");
+
+      static constexpr size_t blocks_for (size_t nrows) { return (nrows + lanes - 1) / lanes; }
+
+      columnar (size_t dim) : dim {dim} {}
+
+      columnar (const columnar&) = delete;
+      columnar (columnar&&) = default;
+      columnar& operator= (const columnar&) = delete;
+      columnar& operator= (columnar&&) = default;
+
+      [[nodiscard]] size_t size () const { return nrows; }
+      [[nodiscard]] size_t nblocks () const { return blocks_for (nrows); }
+      [[nodiscard]] size_t dimension () const { return dim; }
+
+      [[nodiscard]] T at (size_t row, size_t d) const { return cols[(d * stride) + row]; }
+
+      void clear () { nrows = 0; }
+
+      void reserve (size_t nrows_hint) {
+        if (nrows_hint > stride)
+          regrow (blocks_for (nrows_hint) * lanes);
+      }
+
+      template <typename V>
+      void push_back (const V& v) {
+        assert (v.size () == dim);
+        if (nrows == stride)
+          regrow (stride == 0 ? lanes : 2 * stride);
+        for (size_t d = 0; d < dim; ++d)
+          cols[(d * stride) + nrows] = v[d];
+        ++nrows;
+      }
+
+      // Make room for nrows rows, whose content is then set with set_row.
+      void resize (size_t new_nrows) {
+        reserve (new_nrows);
+        nrows = new_nrows;
+      }
+
+      // Overwrite row with v.  Different rows can be set concurrently.
+      template <typename V>
+      void set_row (size_t row, const V& v) {
+        assert (v.size () == dim and row < nrows);
+        for (size_t d = 0; d < dim; ++d)
+          cols[(d * stride) + row] = v[d];
+      }
+
+      // The lanes of block that hold an actual row.
+      [[nodiscard]] lane_mask valid_lanes (size_t block) const {
+        const size_t used = nrows - (block * lanes);
+        return used >= lanes ? ~lane_mask {0} >> ((sizeof (lane_mask) * 8) - lanes)
+                             : (lane_mask {1} << used) - 1;
+      }
+
+      // Rows of block that are componentwise >= v (resp. <= v).  If strict is
+      // set, the rows that are equal to v are not included in geq.  Either
+      // mask can be skipped, and the scan stops as soon as the requested masks
+      // are empty.
+      template <typename V>
+      void compare_block (size_t block, const V& v, lane_mask* geq, lane_mask* leq,
+                          bool strict = false) const {
+        auto mgeq = typename simd::mask_type (geq != nullptr);
+        auto mleq = typename simd::mask_type (leq != nullptr);
+        auto mgt = typename simd::mask_type (not strict);
+        const T* base = cols.data () + (block * lanes);
+
+        for (size_t d = 0; d < dim; ++d, base += stride) {
+          const simd col (base, std::experimental::vector_aligned);
+          const simd vd (static_cast<T> (v[d]));
+          mgeq = mgeq and (col >= vd);
+          mleq = mleq and (col <= vd);
+          if (strict)
+            mgt = mgt or (col > vd);
+          if (std::experimental::none_of (mgeq) and std::experimental::none_of (mleq))
+            break;
+        }
+
+        const lane_mask valid = valid_lanes (block);
+        if (geq != nullptr)
+          *geq = to_lane_mask (mgeq and mgt) & valid;
+        if (leq != nullptr)
+          *leq = to_lane_mask (mleq) & valid;
+      }
+
+      // Whether some row is >= v (strictly if strict is set).
+      template <typename V>
+      [[nodiscard]] bool any_geq (const V& v, bool strict = false) const {
+        for (size_t b = 0; b < nblocks (); ++b) {
+          lane_mask geq;
+          compare_block (b, v, &geq, nullptr, strict);
+          if (geq)
+            return true;
+        }
+        return false;
+      }
+
+      // Remove the rows flagged in removed (one lane mask per block), keeping
+      // the relative order of the remaining rows.
+      void erase (const std::vector<lane_mask>& removed) {
+        assert (removed.size () >= nblocks ());
+        size_t kept = 0;
+        for (size_t d = 0; d < dim; ++d) {
+          T* col = cols.data () + (d * stride);
+          kept = 0;
+          for (size_t r = 0; r < nrows; ++r)
+            if (not (removed[r / lanes] & (lane_mask {1} << (r % lanes))))
+              col[kept++] = col[r];
+        }
+        if (dim == 0)
+          for (size_t r = 0; r < nrows; ++r)
+            kept += not (removed[r / lanes] & (lane_mask {1} << (r % lanes)));
+        nrows = kept;
+      }
+
+      static lane_mask to_lane_mask (const typename simd::mask_type& m) {
+        lane_mask res = 0;
+        for (size_t i = 0; i < lanes; ++i)
+          res |= static_cast<lane_mask> (m[i]) << i;
+        return res;
+      }
+
+    private:
+      void regrow (size_t new_stride) {
+        vector_mm<T> ncols (dim * new_stride);
+        for (size_t d = 0; nrows > 0 and d < dim; ++d)
+          std::memcpy (ncols.data () + (d * new_stride), cols.data () + (d * stride),
+                       nrows * sizeof (T));
+        cols = std::move (ncols);
+        stride = new_stride;
+      }
+
+      size_t dim;
+      size_t nrows = 0;
+      size_t stride = 0;  // Capacity of each column, a multiple of lanes.
+      vector_mm<T> cols;
+  };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * Runtime selection of the instruction set used by the vector kernels, see
+ * vectors/generic_kernels.hh.  Kernels marked with POSETS_TARGET_CLONES are
+ * compiled once per target below, and the dynamic loader picks the best one
+ * for the running CPU, once, when the program starts (GNU ifuncs).  The data
+ * layout of the vectors does not depend on the variant.
+ *
+ * Define POSETS_CPU_DISPATCH to 0 to compile the kernels for the default
+ * target only (e.g., when compiling with -march=native anyway).
+ */
+
+#ifndef POSETS_CPU_DISPATCH
+# if defined(__GNUC__) and not defined(__clang__) and defined(__x86_64__) and defined(__linux__)
+#  define POSETS_CPU_DISPATCH 1
+# else
+#  define POSETS_CPU_DISPATCH 0
+# endif
+#endif
+
+#if POSETS_CPU_DISPATCH
+// Keep in sync with cpu_dispatch_target ().
+# define POSETS_TARGET_CLONES \
+   __attribute__ ((target_clones ("arch=x86-64-v4", "avx2", "sse4.2", "default")))
+#else
+# define POSETS_TARGET_CLONES
+#endif
+
+namespace posets::utils {
+  /// The name of the kernel variant selected for this CPU: one of "avx512",
+  /// "avx2", "sse4.2", or "default".
+  inline const char* cpu_dispatch_target () {
+#if POSETS_CPU_DISPATCH
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("x86-64-v4"))
+      return "avx512";
+    if (__builtin_cpu_supports ("avx2"))
+      return "avx2";
+    if (__builtin_cpu_supports ("sse4.2"))
+      return "sse4.2";
+#endif
+    return "default";
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Runtime selection of a compile-time dimension.  The fixed-size vectors
+ * (array_backed<T, K>, simd_array_backed<T, K>, ...) need K at compile time;
+ * a set of dimension buckets lists the values of K that are instantiated,
+ * and a dimension known at runtime is routed to the smallest bucket that
+ * fits it.  The dispatch is a chain of integer compares, done once per
+ * operation on a whole downset, see downsets/dimension_dispatched.hh.
+ */
+
+namespace posets::utils {
+  template <size_t... Ks>
+  struct dimension_buckets {
+      static constexpr std::array<size_t, sizeof...(Ks)> sizes = {Ks...};
+      static constexpr size_t count = sizeof...(Ks);
+
+      static_assert (count > 0, "No dimension bucket.");
+      static_assert ([] () {
+        for (size_t i = 1; i < count; ++i)
+          if (sizes[i - 1] >= sizes[i])
+            return false;
+        return true;
+      }(), "Dimension buckets should be increasing.");
+
+      /// The index of the smallest bucket that fits dim, or count if none
+      /// does.
+      static constexpr size_t bucket_of (size_t dim) {
+        for (size_t i = 0; i < count; ++i)
+          if (dim <= sizes[i])
+            return i;
+        return count;
+      }
+
+      /// Call f (std::integral_constant<size_t, I> {}), where I is
+      /// bucket_of (dim).  All the calls should have the same return type.
+      template <size_t I = 0, typename F>
+      static decltype (auto) with_bucket (size_t dim, F&& f) {
+        if constexpr (I == count)
+          return std::forward<F> (f) (std::integral_constant<size_t, I> {});
+        else {
+          if (dim <= sizes[I])
+            return std::forward<F> (f) (std::integral_constant<size_t, I> {});
+          return with_bucket<I + 1> (dim, std::forward<F> (f));
+        }
+      }
+  };
+
+  /// Powers of two from 8 to 1024.
+  using default_dimension_buckets = dimension_buckets<8, 16, 32, 64, 128, 256, 512, 1024>;
+
+  /// Call f (std::integral_constant<size_t, K> {}) for the smallest bucket K
+  /// of Buckets that fits dim, or with K = 0 if dim is larger than all the
+  /// buckets.
+  template <typename Buckets = default_dimension_buckets, typename F>
+  decltype (auto) dispatch_dimension (size_t dim, F&& f) {
+    return Buckets::with_bucket (dim, [&f] (auto i) -> decltype (auto) {
+      constexpr size_t I = decltype (i)::value;
+      if constexpr (I == Buckets::count)
+        return std::forward<F> (f) (std::integral_constant<size_t, 0> {});
+      else
+        return std::forward<F> (f) (std::integral_constant<size_t, Buckets::sizes[I]> {});
+    });
+  }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace posets::utils {
+  /// A set stored as a sorted vector, without duplicates.  Lookups are
+  /// binary searches over contiguous memory, and single insertions and
+  /// erasures shift the elements after them; changes that touch many
+  /// elements should go through the bulk operations, which are linear (after
+  /// sorting the new elements, for insert).
+  ///
+  /// The elements are only given out as const, so that the order can't be
+  /// broken from outside.
+  template <typename T, typename Compare = std::less<>>
+  class flat_set {
+      using storage_t = std::vector<T>;
+
+    public:
+      using value_type = T;
+      using iterator = typename storage_t::const_iterator;
+      using const_iterator = iterator;
+
+      flat_set () = default;
+
+      /// The elements need not be sorted, and may have duplicates.
+      explicit flat_set (std::vector<T>&& elements) { insert (std::move (elements)); }
+
+      flat_set (const flat_set&) = delete;
+      flat_set (flat_set&&) = default;
+      flat_set& operator= (const flat_set&) = delete;
+      flat_set& operator= (flat_set&&) = default;
+
+      [[nodiscard]] size_t size () const { return elements.size (); }
+      [[nodiscard]] bool empty () const { return elements.empty (); }
+      void clear () { elements.clear (); }
+      void reserve (size_t n) { elements.reserve (n); }
+
+      [[nodiscard]] iterator begin () const { return elements.cbegin (); }
+      [[nodiscard]] iterator end () const { return elements.cend (); }
+      [[nodiscard]] const T& front () const { return elements.front (); }
+
+      [[nodiscard]] iterator find (const T& v) const {
+        auto it = lower_bound (v);
+        return it != end () and not cmp (v, *it) ? it : end ();
+      }
+
+      [[nodiscard]] bool contains (const T& v) const { return find (v) != end (); }
+
+      /// As for std::set: v is only moved from if it is inserted.
+      std::pair<iterator, bool> insert (T&& v) {
+        auto it = lower_bound (v);
+        if (it != end () and not cmp (v, *it))
+          return {it, false};
+        return {elements.insert (it, std::move (v)), true};
+      }
+
+      /// Insert all the elements of more, which need not be sorted; the
+      /// ones already in the set are dropped.  This sorts more, then merges
+      /// it in place.
+      void insert (std::vector<T>&& more) {
+        std::ranges::sort (more, cmp);
+        const auto mid = static_cast<std::ptrdiff_t> (elements.size ());
+        elements.reserve (elements.size () + more.size ());
+        std::ranges::move (more, std::back_inserter (elements));
+        std::inplace_merge (elements.begin (), elements.begin () + mid, elements.end (), cmp);
+        // Equal elements are now adjacent.
+        auto [first, last] = std::ranges::unique (
+            elements, [this] (const T& a, const T& b) { return not cmp (a, b); });
+        elements.erase (first, last);
+      }
+
+      iterator erase (iterator it) { return elements.erase (it); }
+
+      /// Remove the elements in [from, end ()) that satisfy pred, in a single
+      /// pass.  Returns the number of elements removed.
+      template <typename Pred>
+      size_t erase_if (Pred&& pred, iterator from) {
+        auto first = elements.begin () + (from - begin ());
+        auto [kept_end, last] = std::ranges::remove_if (first, elements.end (), pred);
+        const size_t removed = last - kept_end;
+        elements.erase (kept_end, last);
+        return removed;
+      }
+
+      template <typename Pred>
+      size_t erase_if (Pred&& pred) {
+        return erase_if (std::forward<Pred> (pred), begin ());
+      }
+
+      /// Move the elements out, sorted.
+      std::vector<T> extract () && { return std::move (elements); }
+
+    private:
+      [[nodiscard]] iterator lower_bound (const T& v) const {
+        return std::lower_bound (begin (), end (), v, cmp);
+      }
+
+      storage_t elements;
+      [[no_unique_address]] Compare cmp;
+  };
+}
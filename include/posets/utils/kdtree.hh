@@ -1,8 +1,12 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <map>
@@ -13,6 +17,8 @@
 #include <vector>
 
 #include <posets/concepts.hh>
+#include <posets/utils/columnar.hh>
+#include <posets/utils/thread_pool.hh>
 
 /*
  * This is Shrisha Rao's version of a kd-tree for variable dimension. The
@@ -20,7 +26,63 @@
  * by de Berg et al.
  *
  * Coded by Guillermo A. Perez
+ *
+ * The tree is dynamic: elements can be inserted and removed.  They are
+ * spread over a few static, balanced kd-trees of decreasing sizes, and a
+ * buffer of the last inserted ones, which is scanned; when the buffer is
+ * full, it is merged with the smallest trees into a new one.  Removed
+ * elements are marked dead, and a tree in which most elements are dead is
+ * rebuilt.  Rebuilds are thus amortized, and a full build only happens in
+ * relabel_tree.
+ *
+ * The trees are built by a parallel divide and conquer, which works on a
+ * transposed copy of the keys; large subtrees are split at the median of a
+ * sample rather than at their exact median.  The split axis is the one that a
+ * value splits best on a sample of the elements, and splits that leave
+ * elements equal to the split value on both sides are made clean when that
+ * keeps them balanced, which matters for boolean components.
+ *
+ * The leaves of the trees are buckets of about KDTREE_BUCKET_SIZE elements,
+ * stored transposed (see utils::columnar) so that they are scanned with SIMD
+ * one-vs-many comparisons rather than followed one node at a time.  The
+ * trees are complete, their nodes are packed in 12 bytes and laid out in van
+ * Emde Boas order, and they are searched iteratively, prefetching both
+ * children of each visited node.
+ *
+ * Each node can also store the componentwise maximum of the elements below
+ * it, its max corner: a query skips the subtrees whose corner does not
+ * dominate it.  The corners are not updated on removal, they remain upper
+ * bounds.
  */
+
+// Number of inserted elements that are scanned before being put in a tree.
+#ifndef KDTREE_BUFFER_SIZE
+# define KDTREE_BUFFER_SIZE 32UL
+#endif
+
+// Maximal number of elements in a leaf bucket; this is rounded up to a
+// multiple of the SIMD width.
+#ifndef KDTREE_BUCKET_SIZE
+# define KDTREE_BUCKET_SIZE 32UL
+#endif
+
+// Levels of at least that many elements are built in parallel, and so are
+// the subtrees of at least that many elements.
+#ifndef KDTREE_PARALLEL_CUTOFF
+# define KDTREE_PARALLEL_CUTOFF (1UL << 13)
+#endif
+
+// Subtrees of at least that many elements are split at the median of a
+// sample of their elements, rather than at their exact median.
+#ifndef KDTREE_SAMPLE_THRESHOLD
+# define KDTREE_SAMPLE_THRESHOLD (1UL << 16)
+#endif
+
+// Whether the nodes store their max corner.
+#ifndef KDTREE_MAX_CORNERS
+# define KDTREE_MAX_CORNERS 1
+#endif
+
 namespace posets::utils {
   // Forward definition for the operator<<
   template <Vector>
@@ -32,146 +94,629 @@ namespace posets::utils {
   template <Vector V>
   class kdtree {
     private:
-      struct kdtree_node;
-      using kdtree_node_ptr = kdtree_node*;
-
+      using columns_type = columnar<typename V::value_type>;
+      using lane_mask = typename columns_type::lane_mask;
+      static constexpr size_t lanes = columns_type::lanes;
+      static constexpr size_t bucket_size = columns_type::blocks_for (KDTREE_BUCKET_SIZE) * lanes;
+      static_assert (bucket_size >= 2, "Buckets must be split in nonempty halves.");
+
+      // Trees have at most that many levels of nodes, which is plenty.
+      static constexpr size_t max_height = 64;
+      static constexpr bool max_corners = KDTREE_MAX_CORNERS;
+
+      // A node takes 12 bytes.  All the leaves are at the last depth of the
+      // tree, and they store their bucket in place of the split.
       struct kdtree_node {
-          std::optional<size_t> value_idx;  // only for leaves: the index of
-                                            // the element from the list
-          int location;                     // the value at which we split
-          size_t axis;                      // the dimension at which we
-                                            // split
-          bool clean_split;                 // whether the split is s.t.
-                                            // to the left all is smaller
+          union {
+              int location;          // the value at which we split
+              uint32_t first_block;  // only for leaves: the first block of
+                                     // the bucket in the columns
+          };
+          uint32_t axis : 31;        // the dimension at which we split, or
+                                     // for leaves, the number of blocks
+          uint32_t clean_split : 1;  // whether the split is s.t. to the left
+                                     // all is smaller
+          uint32_t live;             // number of live elements below
+      };
+      static_assert (sizeof (kdtree_node) == 12);
+
+      // The nodes of a tree are named by their BFS index: the root is 1 and
+      // the children of i are 2i and 2i + 1.  They are stored in van Emde
+      // Boas order: a tree is cut at half its height, and its top tree is
+      // stored before its bottom trees, each of them recursively so.  The
+      // position of a node at depth d is then found from that of the root of
+      // the top tree that is cut above d, see Brodal, Fagerberg and Jacob,
+      // "Cache oblivious search trees via binary trees of small height".
+      struct veb_cut {
+          size_t top;        // size of the top tree, also a mask of the BFS
+                             // index giving the bottom tree
+          size_t bottom;     // size of each bottom tree
+          size_t top_depth;  // depth of the root of the top tree
       };
 
+      // A complete balanced kd-tree over some of the elements.  The buckets
+      // are consecutive in columns, each starting on a new block; the rows
+      // that are padding or that were removed are cleared in alive.
+      struct level {
+          level (size_t dim) : columns {dim} {}
+
+          std::unique_ptr<kdtree_node[]> nodes;  // NOLINT(modernize-avoid-c-arrays)
+          std::vector<veb_cut> cuts;             // by depth of the cut
+          size_t height = 0;                     // number of depths
+          size_t built = 0;                      // number of elements
+          std::vector<typename V::value_type> corners;  // dim values per
+                                                        // node, if any
+          columns_type columns;
+          std::vector<size_t> ids;  // the element of each row
+          std::vector<lane_mask> alive;
+      };
+
+      // Where an element is: its level, the BFS index of its leaf and its row
+      // in the columns, or in_buffer and its index in the buffer.
+      struct position {
+          size_t level;
+          size_t pos;
+          size_t row;
+      };
+      static constexpr size_t in_buffer = std::numeric_limits<size_t>::max ();
+
       size_t dim;
-      kdtree_node_ptr tree;
+      std::vector<level> levels;   // by decreasing size, mostly
+      std::vector<size_t> buffer;  // the elements in no level
+      std::vector<position> where;
 
       template <Vector V2>
       friend std::ostream& operator<< (std::ostream& os, const kdtree<V2>& f);
 
+      // The subtrees are split in halves until they fit in a bucket; the
+      // halves at a given depth differ by at most one element, so the last
+      // depth is that of the path that keeps the larger halves.
+      static size_t tree_height (size_t n) {
+        size_t height = 1;
+        for (; n > bucket_size; n -= n / 2)
+          ++height;
+        return height;
+      }
+
+      // NOLINTBEGIN(misc-no-recursion)
+      static void cut_tree (std::vector<veb_cut>& cuts, size_t depth, size_t height) {
+        if (height <= 1)
+          return;
+        const size_t top_height = height / 2;
+        const size_t bottom_depth = depth + top_height;
+        cuts[bottom_depth] = {(size_t {1} << top_height) - 1,
+                              (size_t {1} << (height - top_height)) - 1, depth};
+        cut_tree (cuts, depth, top_height);
+        cut_tree (cuts, bottom_depth, height - top_height);
+      }
+      // NOLINTEND(misc-no-recursion)
+
+      // The position of the node of BFS index bfs at depth d > 0, given the
+      // positions of its ancestors in path.
+      static size_t node_pos (const level& l, const size_t* path, size_t bfs, size_t d) {
+        const auto& cut = l.cuts[d];
+        return path[cut.top_depth] + cut.top + ((bfs & cut.top) * cut.bottom);
+      }
+
+      // Whether the max corner of the node at pos dominates v (strictly if
+      // strict is set), so that some element below it may.
+      bool below_corner (const level& l, size_t pos, const V& v, bool strict) const {
+        const auto* corner = l.corners.data () + (pos * this->dim);
+        bool smaller = not strict;
+        for (size_t d = 0; d < this->dim; ++d) {
+          if (v[d] > corner[d])
+            return false;
+          smaller = smaller or v[d] < corner[d];
+        }
+        return smaller;
+      }
+
+      // The elements of a level being built: the index j of the element in
+      // points, and its key on the axis of the current split.
+      struct build_entry {
+          typename V::value_type key;
+          size_t j;
+      };
+
+      // What the tasks building a level share.  The components of the
+      // elements are copied to contiguous key columns, so that partitioning
+      // reads one column rather than following every element.  The entries of
+      // each leaf end up consecutive, and the leaves are recorded left to
+      // right.
+      struct build_state {
+          level& l;
+          const std::vector<size_t>& points;
+          std::vector<typename V::value_type> keys;  // component d of element
+                                                     // j at (d * n) + j
+          std::vector<build_entry> entries;
+          std::vector<std::pair<size_t, size_t>> leaves;  // ranges of entries
+          std::vector<size_t> leaf_pos;
+      };
+
+      // The axis on which to split the entries [begin, end).  On a sample of
+      // them, we look for the axis that a value splits best, that is, with
+      // the most entries on the smaller side; ties go to the largest spread,
+      // then to the first axis after prev_axis.  Cycling through the axes
+      // would often split on a boolean component on which almost all the
+      // elements agree.
+      size_t choose_axis (const build_state& st, size_t begin, size_t end,
+                          size_t prev_axis) const {
+        using T = typename V::value_type;
+        const size_t n = st.points.size ();
+        const size_t length = end - begin;
+        std::array<size_t, 32> sample;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        std::array<T, 32> vals;         // NOLINT(cppcoreguidelines-pro-type-member-init)
+        const size_t nsample = std::min (length, sample.size ());
+        for (size_t i = 0; i < nsample; ++i)
+          sample[i] = st.entries[begin + ((i * length) / nsample)].j;
+
+        size_t best = (prev_axis + 1) % this->dim;
+        size_t best_balance = 0;
+        long long best_spread = 0;
+        for (size_t step = 1; step <= this->dim; ++step) {
+          const size_t axis = (prev_axis + step) % this->dim;
+          const T* column = st.keys.data () + (axis * n);
+          for (size_t i = 0; i < nsample; ++i)
+            vals[i] = column[sample[i]];
+          const auto [lo, hi] = std::minmax_element (vals.begin (), vals.begin () + nsample);
+          const long long spread = static_cast<long long> (*hi) - *lo;
+          if (spread == 0)
+            continue;
+          // the best value is the median, or the next one
+          auto mid = vals.begin () + (nsample / 2);
+          std::nth_element (vals.begin (), mid, vals.begin () + nsample);
+          const size_t below = std::count_if (vals.begin (), vals.begin () + nsample,
+                                              [mid] (T x) { return x < *mid; });
+          const size_t upto = std::count_if (vals.begin (), vals.begin () + nsample,
+                                             [mid] (T x) { return x <= *mid; });
+          const size_t balance =
+              std::max (std::min (below, nsample - below), std::min (upto, nsample - upto));
+          if (balance > best_balance or (balance == best_balance and spread > best_spread)) {
+            best = axis;
+            best_balance = balance;
+            best_spread = spread;
+          }
+        }
+        return best;
+      }
+
       // NOLINTBEGIN(misc-no-recursion)
       /*
        * This is one of the only interesting parts of the code: building the
-       * kd-tree to make sure it is balanced.
+       * kd-tree to make sure it is balanced.  The buckets themselves are
+       * filled afterwards, in build_level.
        *
-       * NOTE: This assumes that this->tree has been allocated enough memory to
-       * hold the whole (balanced) tree
+       * NOTE: This assumes that l.nodes and l.cuts have been prepared for a
+       * tree of height l.height, and that path holds the positions of the
+       * ancestors of the node.
        */
-      void recursive_build (size_t result,  // where to leave the new tree
-                            const std::vector<size_t>::iterator& begin_it,
-                            const std::vector<size_t>::iterator& end_it, size_t length,
-                            size_t axis) {
+      void recursive_build (build_state& st,
+                            size_t bfs,  // where to leave the new tree
+                            size_t depth, std::array<size_t, max_height> path, size_t begin,
+                            size_t end, size_t prev_axis) const {
+        using T = typename V::value_type;
+        auto& l = st.l;
+        const size_t n = st.points.size ();
+        const size_t length = end - begin;
+
         // sanity checks
-        assert (this->tree != nullptr);
-        assert (static_cast<size_t> (
-                    4 << (int) (std::floor (std::log2 (this->vector_set.size ())))) > result);
-        assert (static_cast<size_t> (std::distance (begin_it, end_it)) == length);
+        assert (l.nodes != nullptr);
+        assert (depth < l.height);
         assert (length > 0);
-        assert (axis < this->dim);
-
-        // if the list of elements is now a singleton, we make a leaf
-        if (length == 1) {
-          this->tree[result].value_idx = *begin_it;
+        assert (prev_axis < this->dim);
+
+        path[depth] = depth == 0 ? 0 : node_pos (l, path.data (), bfs, depth);
+        auto& node = l.nodes[path[depth]];
+        node.live = length;
+        auto* corner = l.corners.data () + (path[depth] * this->dim);
+
+        // at the last depth, this is a leaf
+        if (depth + 1 == l.height) {
+          st.leaves[bfs - (size_t {1} << depth)] = {begin, end};
+          st.leaf_pos[bfs - (size_t {1} << depth)] = path[depth];
+          if (max_corners)
+            for (size_t d = 0; d < this->dim; ++d) {
+              const T* column = st.keys.data () + (d * n);
+              corner[d] = std::numeric_limits<T>::min ();
+              for (size_t e = begin; e < end; ++e)
+                corner[d] = std::max (corner[d], column[st.entries[e].j]);
+            }
           return;
         }
 
-        // Use a selection algorithm to get the median
-        // NOTE: we actually get the item whose index is
-        auto median_it = begin_it + static_cast<ssize_t> (length) / 2;
-        std::nth_element (begin_it, median_it, end_it, [this, &axis] (size_t i1, size_t i2) {
-          return this->vector_set[i1][axis] < this->vector_set[i2][axis];
-        });
-        const size_t median_idx = *median_it;
-        const int loc = this->vector_set[median_idx][axis];
+        const size_t axis = choose_axis (st, begin, end, prev_axis);
+        auto first = st.entries.begin () + static_cast<ssize_t> (begin);
+        auto last = st.entries.begin () + static_cast<ssize_t> (end);
+        const T* column = st.keys.data () + (axis * n);
+        for (auto it = first; it != last; ++it)
+          it->key = column[it->j];
+        auto by_key = [] (const build_entry& e1, const build_entry& e2) {
+          return e1.key < e2.key;
+        };
+
+        // A split at a value, all the elements smaller than it going to the
+        // left, is clean.  It is only taken if it is not too uneven, and if
+        // each subtree still has at least one element per leaf.
+        const size_t child_leaves = size_t {1} << (l.height - depth - 2);
+        auto balanced = [&] (size_t split) {
+          return std::min (split, length - split) >= std::max (length / 8, child_leaves);
+        };
+        auto split_at = [&] (T value) {
+          auto mid = std::partition (first, last,
+                                     [value] (const build_entry& e) { return e.key < value; });
+          return static_cast<size_t> (mid - first);
+        };
+
+        // On large inputs, we first try to split at the median of a sample.
+        size_t split = 0;
+        int loc = 0;
+        bool clean = true;
+        if (length >= KDTREE_SAMPLE_THRESHOLD) {
+          std::array<T, 127> sample;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+          for (size_t i = 0; i < sample.size (); ++i)
+            sample[i] = first[static_cast<ssize_t> ((i * length) / sample.size ())].key;
+          std::ranges::nth_element (sample, sample.begin () + (sample.size () / 2));
+          const T pivot = sample[sample.size () / 2];
+          split = split_at (pivot);
+          if (balanced (split))
+            loc = pivot;
+          else
+            split = 0;
+        }
 
-        // check whether the maximal element on the left is equal to loc
-        // (with respect to dimension axis) to determine if the split is clean
-        auto max_it = std::max_element (begin_it, median_it, [this, &axis] (size_t i1, size_t i2) {
-          return this->vector_set[i1][axis] < this->vector_set[i2][axis];
-        });
-        const size_t max_idx = *max_it;
-        const bool clean = (this->vector_set[max_idx][axis] < loc);
+        if (split == 0) {
+          // Use a selection algorithm to get the median
+          split = length / 2;
+          auto median_it = first + static_cast<ssize_t> (split);
+          std::nth_element (first, median_it, last, by_key);
+          loc = median_it->key;
+
+          // check whether the maximal element on the left is equal to loc
+          // (with respect to dimension axis) to determine if the split is
+          // clean
+          clean = std::max_element (first, median_it, by_key)->key < loc;
+
+          // If it is not, elements equal to loc are on both sides; this is
+          // typical of components with few values, such as booleans.  We
+          // then move them all to the side that keeps the split balanced.
+          if (not clean) {
+            size_t below = 0, at = 0;
+            for (auto it = first; it != last; ++it) {
+              below += it->key < loc;
+              at += it->key == loc;
+            }
+            auto uneven = [length] (size_t s) { return std::max (s, length - s); };
+            const bool can_raise =
+                loc < std::numeric_limits<T>::max () and balanced (below + at);
+            if (balanced (below) and
+                (not can_raise or uneven (below) <= uneven (below + at))) {
+              split = split_at (static_cast<T> (loc));
+              clean = true;
+            }
+            else if (can_raise) {
+              loc = loc + 1;
+              split = split_at (static_cast<T> (loc));
+              clean = true;
+            }
+          }
+        }
 
         // some sanity checks about the sublists
-        assert (std::distance (begin_it, median_it) > 0);
-        assert (std::distance (median_it, end_it) > 0);
-        assert (static_cast<size_t> (std::distance (begin_it, median_it)) == length / 2);
-        assert (static_cast<size_t> (std::distance (median_it, end_it)) == length - (length / 2));
-        assert (static_cast<size_t> (std::distance (begin_it, median_it)) +
-                    std::distance (median_it, end_it) ==
-                length);
-        assert (this->vector_set[max_idx][axis] <= loc);
-
-        // the next axis is just the following dimension, wrapping around
-        const size_t next_axis = (axis + 1) % this->dim;
+        assert (split > 0 and split < length);
+        assert (std::ranges::all_of (first, first + static_cast<ssize_t> (split),
+                                     [loc] (const auto& e) { return e.key <= loc; }));
+        assert (std::ranges::all_of (first + static_cast<ssize_t> (split), last,
+                                     [loc] (const auto& e) { return e.key >= loc; }));
+
         // we can now prepare the information of the root node and then
-        // recursively prepare the left and right children
-        this->tree[result].value_idx = std::nullopt;
-        this->tree[result].location = loc;
-        this->tree[result].axis = axis;
-        this->tree[result].clean_split = clean;
-        // now the recursive calls
-        recursive_build ((result * 2) + 1, begin_it, median_it, length / 2, next_axis);
-        recursive_build ((result * 2) + 2, median_it, end_it, length - (length / 2), next_axis);
+        // recursively prepare the left and right children, in parallel if
+        // they are large enough
+        node.location = loc;
+        node.axis = axis;
+        node.clean_split = clean;
+        auto left = [&] {
+          recursive_build (st, 2 * bfs, depth + 1, path, begin, begin + split, axis);
+        };
+        auto right = [&] {
+          recursive_build (st, (2 * bfs) + 1, depth + 1, path, begin + split, end, axis);
+        };
+        if (length >= KDTREE_PARALLEL_CUTOFF)
+          thread_pool::global ().invoke (left, right);
+        else {
+          left ();
+          right ();
+        }
+
+        // the max corner is that of the children
+        if (max_corners) {
+          const auto* lcorner =
+              l.corners.data () + (node_pos (l, path.data (), 2 * bfs, depth + 1) * this->dim);
+          const auto* rcorner =
+              l.corners.data () +
+              (node_pos (l, path.data (), (2 * bfs) + 1, depth + 1) * this->dim);
+          for (size_t d = 0; d < this->dim; ++d)
+            corner[d] = std::max (lcorner[d], rcorner[d]);
+        }
       }
+      // NOLINTEND(misc-no-recursion)
 
       /*
        * And this is the second interesting piece of code, using the
        * properties of how the kd-tree was constructed to look for an element
        * that dominates a given vector.
-       * NOTE: Through the recursive calls we keep track of dim variables
-       * which store the lower bounds of the region of the current node and a
-       * counter dims_to_dom which records the dimensions on which the current
-       * region is not yet dominating the region of v
+       * NOTE: Along the search we keep track of dim variables which store the
+       * lower bounds of the region of the current node and a counter
+       * dims_to_dom which records the dimensions on which the current region
+       * is not yet dominating the region of v.  The right subtree is
+       * searched first; a frame of the stack remembers the bound to restore
+       * afterwards, and whether the left subtree is to be searched.
        */
-      bool recursive_dominates (const V& v, bool strict, size_t node_idx, int* lbounds,
-                                size_t dims_to_dom) const {
-        // sanity checks
-        assert (this->tree != nullptr);
-        assert (static_cast<size_t> (
-                    4 << (int) (std::floor (std::log2 (this->vector_set.size ())))) > node_idx);
-        assert (dims_to_dom > 0);
-
-        // from index to node pointer
-        kdtree_node_ptr node = this->tree + node_idx;
-
-        // if we are at a leaf, just check if it dominates
-        if (node->value_idx) {
-          auto po = v.partial_order (this->vector_set[*(node->value_idx)]);
-          if (strict)
-            return po.leq () and not po.geq ();
-          return po.leq ();
+      bool level_dominates (const level& l, const V& v, bool strict, int* lbounds) const {
+        struct frame {
+            size_t bfs, depth, pos, dims_to_dom, axis;
+            int old_bound;
+            bool visit_left;
+        };
+        std::array<frame, max_height> stack;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        size_t top = 0;
+        std::array<size_t, max_height> path;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        size_t bfs = 1;
+        size_t depth = 0;
+        size_t dims_to_dom = this->dim;
+        path[0] = 0;
+
+        while (true) {
+          const kdtree_node& node = l.nodes[path[depth]];
+          assert (dims_to_dom > 0);
+
+          // subtrees whose leaves were all removed, or that are not above v,
+          // are skipped
+          if (node.live == 0 or (max_corners and not below_corner (l, path[depth], v, strict))) {}
+          // if we are at a leaf, scan its bucket
+          else if (depth + 1 == l.height) {
+            for (size_t b = node.first_block; b < node.first_block + node.axis; ++b) {
+              lane_mask geq;
+              l.columns.compare_block (b, v, &geq, nullptr, strict);
+              if (geq & l.alive[b])
+                return true;
+            }
+          }
+          // so we're at an inner node!
+          else {
+            const size_t left = node_pos (l, path.data (), 2 * bfs, depth + 1);
+            const size_t right = node_pos (l, path.data (), (2 * bfs) + 1, depth + 1);
+            __builtin_prefetch (&l.nodes[left]);
+            __builtin_prefetch (&l.nodes[right]);
+
+            // let's check if the right subtree is guaranteed to have a
+            // dominating vector
+            const int old_bound = lbounds[node.axis];
+            size_t still_to_dom = dims_to_dom;
+            assert (node.location >= old_bound);
+            // the axis is dominated once the bound goes past v (or reaches
+            // it, if not strict); it must not be counted twice
+            if (strict ? (node.location > v[node.axis] and old_bound <= v[node.axis])
+                       : (node.location >= v[node.axis] and old_bound < v[node.axis]))
+              still_to_dom--;
+            if (still_to_dom == 0 and l.nodes[right].live > 0)
+              return true;
+
+            // the left subtree is pertinent unless all its elements are
+            // smaller than v on the axis
+            const bool visit_left = not (v[node.axis] > node.location or
+                                         (v[node.axis] == node.location and node.clean_split));
+            stack[top++] = {2 * bfs,    depth + 1, left, dims_to_dom, node.axis, old_bound,
+                            visit_left};
+            lbounds[node.axis] = node.location;
+
+            // if we got here, we need to check on the right
+            if (still_to_dom > 0) {
+              bfs = (2 * bfs) + 1;
+              path[++depth] = right;
+              dims_to_dom = still_to_dom;
+              continue;
+            }
+          }
+
+          // backtrack to the last pertinent left subtree
+          while (true) {
+            if (top == 0)
+              return false;
+            const frame& f = stack[--top];
+            lbounds[f.axis] = f.old_bound;
+            if (f.visit_left) {
+              bfs = f.bfs;
+              depth = f.depth;
+              path[depth] = f.pos;
+              dims_to_dom = f.dims_to_dom;
+              break;
+            }
+          }
         }
+      }
 
-        // so we're at an inner node!
-        // let's check if the right subtree
-        // is guaranteed to have a dominating vector
-        const int old_bound = lbounds[node->axis];
-        size_t still_to_dom = dims_to_dom;
-        assert (node->location >= old_bound);
-        if ((node->location > v[node->axis] and old_bound <= v[node->axis]) or
-            (not strict and node->location >= v[node->axis] and old_bound < v[node->axis]))
-          still_to_dom--;
-        if (still_to_dom == 0)
-          return true;
-        lbounds[node->axis] = node->location;
-
-        // if we got here, we need to check on the right recursively
-        const bool r_succ =
-            recursive_dominates (v, strict, (2 * node_idx) + 2, lbounds, still_to_dom);
-        if (r_succ)
-          return true;
-
-        // all that's left is to check on the left recursively, if pertinent
-        lbounds[node->axis] = old_bound;
-        if (v[node->axis] > node->location or
-            (v[node->axis] == node->location and node->clean_split)) {
-          return false;
+      // Append to out the live elements of l that are smaller than or equal
+      // to v.  The right subtree only holds elements that are at least
+      // node.location on node.axis.
+      void level_dominated (const level& l, const V& v, std::vector<size_t>& out) const {
+        // The pending subtrees, as BFS index, depth and position; the stack
+        // holds at most one sibling per depth, plus the root.
+        std::array<std::array<size_t, 3>, max_height + 1> stack;  // NOLINT
+        size_t top = 0;
+        std::array<size_t, max_height> path;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        stack[top++] = {1, 0, 0};
+        while (top > 0) {
+          const auto [bfs, depth, pos] = stack[--top];
+          path[depth] = pos;
+          const kdtree_node& node = l.nodes[pos];
+          if (node.live == 0)
+            continue;
+          if (depth + 1 == l.height) {
+            for (size_t b = node.first_block; b < node.first_block + node.axis; ++b) {
+              lane_mask leq;
+              l.columns.compare_block (b, v, nullptr, &leq);
+              for (leq &= l.alive[b]; leq != 0; leq &= leq - 1)
+                out.push_back (l.ids[(b * lanes) + std::countr_zero (leq)]);
+            }
+            continue;
+          }
+          if (node.location <= v[node.axis])
+            stack[top++] = {(2 * bfs) + 1, depth + 1,
+                            node_pos (l, path.data (), (2 * bfs) + 1, depth + 1)};
+          stack[top++] = {2 * bfs, depth + 1, node_pos (l, path.data (), 2 * bfs, depth + 1)};
         }
-        // it is pertinent after all
-        return recursive_dominates (v, strict, (2 * node_idx) + 1, lbounds, dims_to_dom);
+      }
+
+      // Build levels[lvl] over the elements of points.
+      void build_level (size_t lvl, std::vector<size_t>& points) {
+        auto& l = this->levels[lvl];
+        l.built = points.size ();
+        l.columns.clear ();
+        l.ids.clear ();
+        l.alive.clear ();
+        // an empty level is a single leaf with no blocks
+        l.height = points.empty () ? 1 : tree_height (points.size ());
+        assert (l.height <= max_height);
+        l.cuts.assign (l.height, {});
+        cut_tree (l.cuts, 0, l.height);
+        const size_t leaves = size_t {1} << (l.height - 1);
+        const size_t nnodes = (2 * leaves) - 1;
+        l.nodes = std::make_unique<kdtree_node[]> (nnodes);  // NOLINT(modernize-avoid-c-arrays)
+        if (max_corners)
+          l.corners.resize (nnodes * this->dim);
+        if (points.empty ())
+          return;
+
+        // Large levels are built in parallel.
+        const size_t n = points.size ();
+        auto for_chunks = [n] (size_t count, size_t grain, const auto& f) {
+          if (n >= KDTREE_PARALLEL_CUTOFF)
+            thread_pool::global ().for_chunks (count, grain, f);
+          else
+            f (0, count);
+        };
+
+        build_state st {l, points, {}, {}, {}, {}};
+        st.keys.resize (this->dim * n);
+        st.entries.resize (n);
+        for_chunks (n, 1024, [&] (size_t lo, size_t hi) {
+          for (size_t j = lo; j < hi; ++j) {
+            st.entries[j].j = j;
+            for (size_t d = 0; d < this->dim; ++d)
+              st.keys[(d * n) + j] = this->vector_set[points[j]][d];
+          }
+        });
+        st.leaves.resize (leaves);
+        st.leaf_pos.resize (leaves);
+        recursive_build (st, 1, 0, {}, 0, n, this->dim - 1);
+
+        // The buckets are laid out left to right, each starting on a new
+        // block, and are then filled independently.
+        std::vector<size_t> first_block (leaves + 1, 0);
+        for (size_t k = 0; k < leaves; ++k)
+          first_block[k + 1] = first_block[k] + columns_type::blocks_for (st.leaves[k].second -
+                                                                          st.leaves[k].first);
+        l.columns.resize (first_block[leaves] * lanes);
+        l.ids.resize (first_block[leaves] * lanes);
+        l.alive.resize (first_block[leaves]);
+        for_chunks (leaves, 16, [&] (size_t lo, size_t hi) {
+          for (size_t k = lo; k < hi; ++k) {
+            const auto [begin, end] = st.leaves[k];
+            auto& node = l.nodes[st.leaf_pos[k]];
+            node.first_block = first_block[k];
+            node.axis = first_block[k + 1] - first_block[k];
+            size_t row = first_block[k] * lanes;
+            for (size_t e = begin; e < end; ++e, ++row) {
+              const size_t id = points[st.entries[e].j];
+              this->where[id] = {lvl, leaves + k, row};
+              l.columns.set_row (row, this->vector_set[id]);
+              l.ids[row] = id;
+            }
+            // pad the last block, the padding is never alive
+            for (; row < first_block[k + 1] * lanes; ++row) {
+              l.columns.set_row (row, this->vector_set[l.ids[first_block[k] * lanes]]);
+              l.ids[row] = l.ids[first_block[k] * lanes];
+            }
+            for (size_t b = 0; b < node.axis; ++b) {
+              const size_t used = std::min (lanes, end - begin - (b * lanes));
+              l.alive[first_block[k] + b] =
+                  used == sizeof (lane_mask) * 8 ? ~lane_mask {0} : (lane_mask {1} << used) - 1;
+            }
+          }
+        });
+      }
+
+      // Append the live elements of l to points.
+      void collect (const level& l, std::vector<size_t>& points) const {
+        for (size_t b = 0; b < l.alive.size (); ++b)
+          for (lane_mask m = l.alive[b]; m != 0; m &= m - 1)
+            points.push_back (l.ids[(b * lanes) + std::countr_zero (m)]);
+      }
+
+      // This is the logarithmic method of Bentley and Saxe: the buffer is
+      // merged with the smallest levels, as long as they are not larger than
+      // what is merged so far, into a new level.  An element thus takes part
+      // in O(log n) builds.
+      void flush_buffer () {
+        std::vector<size_t> points = std::move (this->buffer);
+        this->buffer.clear ();
+        while (not this->levels.empty () and
+               this->levels.back ().nodes[0].live <= points.size ()) {
+          collect (this->levels.back (), points);
+          this->levels.pop_back ();
+        }
+        this->levels.emplace_back (this->dim);
+        build_level (this->levels.size () - 1, points);
+      }
+
+      // Rebuild the levels in which more than half of the leaves were
+      // removed, and drop the empty ones at the end.
+      void compact_levels () {
+        for (size_t lvl = 0; lvl < this->levels.size (); ++lvl)
+          if (2 * this->levels[lvl].nodes[0].live < this->levels[lvl].built) {
+            std::vector<size_t> points;
+            collect (this->levels[lvl], points);
+            build_level (lvl, points);
+          }
+        while (not this->levels.empty () and this->levels.back ().nodes[0].live == 0)
+          this->levels.pop_back ();
+      }
+
+      // Remove the element at index i; the last element takes its place.
+      void erase_at (size_t i) {
+        const auto [lvl, pos, row] = this->where[i];
+        if (lvl == in_buffer) {
+          const size_t moved = this->buffer.back ();
+          this->buffer[pos] = moved;
+          this->where[moved].pos = pos;
+          this->buffer.pop_back ();
+        }
+        else {
+          // the row stays, but is not counted as live anymore
+          auto& l = this->levels[lvl];
+          l.alive[row / lanes] &= ~(lane_mask {1} << (row % lanes));
+          // the ancestor of the leaf at depth d has BFS index pos >> (height
+          // - 1 - d)
+          std::array<size_t, max_height> path;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+          path[0] = 0;
+          --l.nodes[0].live;
+          for (size_t d = 1; d < l.height; ++d) {
+            path[d] = node_pos (l, path.data (), pos >> (l.height - 1 - d), d);
+            --l.nodes[path[d]].live;
+          }
+        }
+
+        const size_t last = this->vector_set.size () - 1;
+        if (i != last) {
+          this->vector_set[i] = std::move (this->vector_set[last]);
+          this->where[i] = this->where[last];
+          if (this->where[i].level == in_buffer)
+            this->buffer[this->where[i].pos] = i;
+          else
+            this->levels[this->where[i].level].ids[this->where[i].row] = i;
+        }
+        this->vector_set.pop_back ();
+        this->where.pop_back ();
       }
 
       std::vector<V> vector_set;
@@ -186,12 +731,6 @@ namespace posets::utils {
         assert (elements.size () > 0);
         assert (this->dim > 0);
 
-        // Let n be the size of vector_set, the no. of leaves in the tree is
-        // 2^{floor(lg(n)) + 1}, so this times 2 is the size of the full
-        // binary tree we will be labelling
-        const size_t oldsize = 4 << (size_t) (std::floor (std::log2 (this->vector_set.size ())));
-        const size_t tsize = 4 << (size_t) (std::floor (std::log2 (elements.size ())));
-
         // moving the given elements to the internal data structure
         std::vector<V> newset;
         newset.reserve (elements.size ());
@@ -208,56 +747,64 @@ namespace posets::utils {
         // NOLINTBEGIN(boost-use-ranges)
         std::iota (points.begin (), points.end (), 0);
         // NOLINTEND(boost-use-ranges)
-        if (this->tree == nullptr)
-          this->tree = new kdtree_node[tsize];
-        if (this->tree != nullptr and oldsize < tsize) {
-          delete[] this->tree;
-          this->tree = new kdtree_node[tsize];
-        }
-        recursive_build (0, points.begin (), points.end (), points.size (), 0);
+        this->levels.clear ();
+        this->buffer.clear ();
+        this->where.resize (this->vector_set.size ());
+        this->levels.emplace_back (this->dim);
+        build_level (0, points);
       }
-      // NOLINTEND(misc-no-recursion)
 
-      kdtree ()
-        : tree (nullptr) {}  // FIXME: shall we delete this? it makes a kdtree
-                             // without knowing the size of anything!
-      kdtree (size_t dim) : dim (dim), tree (nullptr) {}
+      kdtree () : dim (0) {}  // FIXME: shall we delete this? it makes a kdtree
+                              // without knowing the size of anything!
+      kdtree (size_t dim) : dim (dim) {}
       kdtree (size_t dim, size_t initsize) : dim (dim) {
-        const size_t tsize = 4 << (size_t) (std::floor (std::log2 (initsize)));
-        this->tree = new kdtree_node[tsize];
+        this->vector_set.reserve (initsize);
+        this->where.reserve (initsize);
       }
 
       template <std::ranges::input_range R, class Proj = std::identity>
-      kdtree (R&& elements, Proj proj = {})
-        : dim (proj (*elements.begin ()).size ()),
-          tree (nullptr) {
+      kdtree (R&& elements, Proj proj = {}) : dim (proj (*elements.begin ()).size ()) {
         relabel_tree (std::forward<R> (elements), proj);
       }
 
       kdtree (const kdtree& other) = delete;
-      kdtree (kdtree&& other) noexcept
-        : dim (other.dim),
-          tree (other.tree),
-          vector_set (std::move (other.vector_set)) {
-        other.tree = nullptr;
+      kdtree (kdtree&& other) noexcept = default;
+      kdtree& operator= (kdtree&& other) noexcept = default;
+
+      /// Add v to the tree.  It goes to a buffer that is scanned linearly,
+      /// and that is merged into the trees once it holds KDTREE_BUFFER_SIZE
+      /// elements.  This does not check that the elements remain an
+      /// antichain, see kdtree_backed::insert.
+      void insert (V&& v) {
+        if (this->vector_set.empty ())
+          this->dim = v.size ();
+        assert (v.size () == this->dim);
+        this->where.push_back ({in_buffer, this->buffer.size (), 0});
+        this->buffer.push_back (this->vector_set.size ());
+        this->vector_set.push_back (std::move (v));
+        if (this->buffer.size () >= KDTREE_BUFFER_SIZE)
+          flush_buffer ();
       }
 
-      ~kdtree () { delete[] this->tree; }
-
-      kdtree& operator= (kdtree&& other) noexcept {
-        this->dim = other.dim;
-        this->vector_set = std::move (other.vector_set);
-        // WARNING: 3 variable follows to make the whole thing safe for
-        // self-assignment
-        kdtree_node_ptr temp_tree = other.tree;
-        other.tree = nullptr;
-        // NOTE: this must be here, after having a local copy of the other
-        // tree and before moving it to here, because of self-assignment
-        // safety!
-        delete[] this->tree;
-        // we now copy things here and return
-        this->tree = temp_tree;
-        return *this;
+      /// Remove the elements that are smaller than or equal to v, and return
+      /// their number.  This moves the last elements of the backing vector to
+      /// the freed places.
+      size_t erase_dominated (const V& v) {
+        std::vector<size_t> out;
+        for (auto i : this->buffer)
+          if (this->vector_set[i].partial_order (v).leq ())
+            out.push_back (i);
+        for (const auto& l : this->levels)
+          level_dominated (l, v, out);
+        if (out.empty ())
+          return 0;
+        // Removing from the largest index, the elements that are moved are
+        // never in out.
+        std::ranges::sort (out, std::greater<> ());
+        for (auto i : out)
+          erase_at (i);
+        compact_levels ();
+        return out.size ();
       }
 
       [[nodiscard]] auto& get_backing_vector () { return vector_set; }
@@ -265,9 +812,20 @@ namespace posets::utils {
       [[nodiscard]] const auto& get_backing_vector () const { return vector_set; }
 
       [[nodiscard]] bool dominates (const V& v, bool strict = false) const {
-        int lbounds[this->dim];  // NOLINT(modernize-avoid-c-arrays)
-        std::fill_n (lbounds, this->dim, std::numeric_limits<int>::min ());
-        return this->recursive_dominates (v, strict, 0, lbounds, this->dim);
+        for (auto i : this->buffer) {
+          auto po = v.partial_order (this->vector_set[i]);
+          if (po.leq () and not (strict and po.geq ()))
+            return true;
+        }
+        if (this->levels.empty ())
+          return false;
+        thread_local std::vector<int> lbounds;
+        for (const auto& l : this->levels) {
+          lbounds.assign (this->dim, std::numeric_limits<int>::min ());
+          if (this->level_dominates (l, v, strict, lbounds.data ()))
+            return true;
+        }
+        return false;
       }
 
       [[nodiscard]] bool is_antichain () const {
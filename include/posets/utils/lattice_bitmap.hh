@@ -0,0 +1,174 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace posets::utils {
+  /// A set of points of a box of N^d, as a bitmap.  The sides of the box are
+  /// powers of two, so that the rank of a point is the concatenation of its
+  /// components, component 0 in the lowest bits.  With s = 2^shift (i), the
+  /// points that only differ in component i are s bits apart, and the slab of
+  /// the points with a given component i is made of runs of s contiguous
+  /// bits.  The passes along component i thus work on whole words when s is
+  /// at least the size of a word, and with shifts and masks within the words
+  /// otherwise; either way, they are plain loops over the words, which the
+  /// compiler vectorizes.
+  class lattice_bitmap {
+    public:
+      /// The box has 2^widths[i] points along component i.
+      explicit lattice_bitmap (std::vector<unsigned> widths_) : widths {std::move (widths_)} {
+        unsigned total = 0;
+        for (auto w : widths) {
+          shifts.push_back (total);
+          total += w;
+        }
+        words.resize (total > log_word ? size_t {1} << (total - log_word) : 1);
+      }
+
+      lattice_bitmap (const lattice_bitmap&) = delete;
+      lattice_bitmap (lattice_bitmap&&) = default;
+      lattice_bitmap& operator= (const lattice_bitmap&) = delete;
+      lattice_bitmap& operator= (lattice_bitmap&&) = default;
+
+      [[nodiscard]] size_t dim () const { return widths.size (); }
+      [[nodiscard]] unsigned width (size_t i) const { return widths[i]; }
+      [[nodiscard]] unsigned shift (size_t i) const { return shifts[i]; }
+      [[nodiscard]] bool same_shape (const lattice_bitmap& other) const {
+        return widths == other.widths;
+      }
+
+      void set (uint64_t rank) { words[rank / word_bits] |= uint64_t {1} << (rank % word_bits); }
+
+      [[nodiscard]] bool test (uint64_t rank) const {
+        return (words[rank / word_bits] >> (rank % word_bits)) & 1;
+      }
+
+      [[nodiscard]] uint64_t count () const {
+        uint64_t n = 0;
+        for (auto w : words)
+          n += std::popcount (w);
+        return n;
+      }
+
+      void or_with (const lattice_bitmap& other) {
+        assert (same_shape (other));
+        for (size_t j = 0; j < words.size (); ++j)
+          words[j] |= other.words[j];
+      }
+
+      void and_with (const lattice_bitmap& other) {
+        assert (same_shape (other));
+        for (size_t j = 0; j < words.size (); ++j)
+          words[j] &= other.words[j];
+      }
+
+      /// Add all the points of the box below a point of the set.  This is a
+      /// suffix-OR along each component in turn: each slab is ORed into the
+      /// one below it, from the top.
+      void close_downward () {
+        for (size_t i = 0; i < dim (); ++i) {
+          if (widths[i] == 0)
+            continue;
+          const uint64_t s = uint64_t {1} << shifts[i], block = s << widths[i];
+
+          if (block <= word_bits)
+            // Whole lines in a word: log2 (radix) doubling steps, masked so
+            // that nothing leaks from one line into the next.
+            for (uint64_t k = s; k < block; k *= 2) {
+              const uint64_t mask = repeat (low_bits (block - k), block);
+              for (auto& w : words)
+                w |= (w >> k) & mask;
+            }
+          else if (s < word_bits) {
+            // Lines over several words: a word holds a few slabs, and once
+            // it is closed its lowest slab is carried to all the slabs of
+            // the word before it.
+            const size_t line_words = block / word_bits;
+            const uint64_t spread = repeat (1, s);
+            for (size_t b = 0; b < words.size (); b += line_words)
+              for (size_t j = b + line_words; j-- > b;) {
+                for (uint64_t k = s; k < word_bits; k *= 2)
+                  words[j] |= words[j] >> k;
+                if (j + 1 < b + line_words)
+                  words[j] |= (words[j + 1] & low_bits (s)) * spread;
+              }
+          }
+          else {
+            // Slabs of whole words.
+            const size_t slab_words = s / word_bits, line_words = block / word_bits;
+            for (size_t b = 0; b < words.size (); b += line_words)
+              for (size_t c = line_words - slab_words; c > 0; c -= slab_words)
+                for (size_t t = 0; t < slab_words; ++t)
+                  words[b + c - slab_words + t] |= words[b + c + t];
+          }
+        }
+      }
+
+      /// The points of the set such that no point right above them, along
+      /// any component, is in the set.  For a downward closed set, these are
+      /// its maximal elements.
+      [[nodiscard]] lattice_bitmap maxima () const {
+        lattice_bitmap res (widths);
+        res.words = words;
+        for (size_t i = 0; i < dim (); ++i) {
+          if (widths[i] == 0)
+            continue;
+          const uint64_t s = uint64_t {1} << shifts[i], block = s << widths[i];
+
+          // Remove the points whose successor along i is in the set.
+          if (block <= word_bits) {
+            const uint64_t mask = repeat (low_bits (block - s), block);
+            for (size_t j = 0; j < words.size (); ++j)
+              res.words[j] &= ~((words[j] >> s) & mask);
+          }
+          else if (s < word_bits) {
+            const size_t line_words = block / word_bits;
+            for (size_t j = 0; j < words.size (); ++j) {
+              uint64_t above = words[j] >> s;
+              if ((j + 1) % line_words != 0)
+                above |= words[j + 1] << (word_bits - s);
+              res.words[j] &= ~above;
+            }
+          }
+          else {
+            const size_t slab_words = s / word_bits, line_words = block / word_bits;
+            for (size_t b = 0; b < words.size (); b += line_words)
+              for (size_t c = 0; c + slab_words < line_words; c += slab_words)
+                for (size_t t = 0; t < slab_words; ++t)
+                  res.words[b + c + t] &= ~words[b + c + slab_words + t];
+          }
+        }
+        return res;
+      }
+
+      /// Call f on the rank of each point of the set, in increasing order.
+      template <typename F>
+      void for_each (F&& f) const {
+        for (size_t j = 0; j < words.size (); ++j)
+          for (uint64_t w = words[j]; w != 0; w &= w - 1)
+            f (j * word_bits + std::countr_zero (w));
+      }
+
+    private:
+      static constexpr unsigned log_word = 6;
+      static constexpr uint64_t word_bits = uint64_t {1} << log_word;
+
+      static uint64_t low_bits (uint64_t n) {
+        return n >= word_bits ? ~uint64_t {0} : (uint64_t {1} << n) - 1;
+      }
+
+      // pattern, copied every period bits.
+      static uint64_t repeat (uint64_t pattern, uint64_t period) {
+        uint64_t res = 0;
+        for (uint64_t p = 0; p < word_bits; p += period)
+          res |= pattern << p;
+        return res;
+      }
+
+      std::vector<unsigned> widths;
+      std::vector<unsigned> shifts;
+      std::vector<uint64_t> words;
+  };
+}
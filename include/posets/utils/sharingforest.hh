@@ -3,7 +3,9 @@
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <numeric>
@@ -611,6 +613,57 @@ namespace posets::utils {
         }
         return add_node (new_node, current_layer);
       }
+
+      // The number of vectors with components at least -1, over the
+      // components from layer - 1 on, that are below a vector of the language
+      // of one of the nodes.  The vectors with value x in the component of the
+      // layer are those below the children of the nodes with a label at least
+      // x, so the labels split the values in ranges, each counted with a
+      // recursive call on a set of children.  Nodes simulated by another node
+      // of the set are dropped first, and the counts are memoized per set.
+      uint64_t count_below (std::vector<size_t> nodes, size_t layer,
+                            std::vector<std::map<std::vector<size_t>, uint64_t>>& memo) {
+        if (layer > this->dim)
+          return 1;
+
+        std::ranges::sort (nodes);
+        nodes.erase (std::unique (nodes.begin (), nodes.end ()), nodes.end ());
+        std::vector<size_t> kept;
+        for (auto n : nodes) {
+          if (std::ranges::any_of (kept, [&] (size_t k) { return simulates (k, n, layer); }))
+            continue;
+          std::erase_if (kept, [&] (size_t k) { return simulates (n, k, layer); });
+          kept.push_back (n);
+        }
+        std::ranges::sort (kept);
+        auto cached = memo[layer].find (kept);
+        if (cached != memo[layer].end ())
+          return cached->second;
+
+        std::vector<size_t> by_label {kept};
+        std::ranges::sort (by_label, std::greater<> (),
+                           [&] (size_t n) { return layers[layer][n].label; });
+        uint64_t total = 0;
+        std::vector<size_t> children;
+        for (size_t k = 0; k < by_label.size (); ++k) {
+          const st_node node = layers[layer][by_label[k]];
+          const long label = node.label;
+          if (label < -1)
+            break;
+          if (layer < this->dim)
+            children.insert (children.end (), child_buffer + node.cbuffer_offset,
+                             child_buffer + node.cbuffer_offset + node.numchild);
+          const long next =
+              k + 1 < by_label.size () ? std::max<long> (layers[layer][by_label[k + 1]].label, -2)
+                                       : -2;
+          // Nodes with the same label share their range.
+          if (next == label)
+            continue;
+          total += static_cast<uint64_t> (label - next) * count_below (children, layer + 1, memo);
+        }
+        memo[layer].emplace (std::move (kept), total);
+        return total;
+      }
       // NOLINTEND(misc-no-recursion)
 
     public:
@@ -785,6 +838,22 @@ namespace posets::utils {
         return add_node (under_construction, 0);
       }
 
+      /* Number of vectors with components at least -1 that are below a vector
+       * in the language of the given tree root (see utils::closure_size).
+       *
+       * Complexity: this is dynamic programming over the DAG, on sets of nodes
+       * of a layer rather than on single nodes, so it may be exponential in
+       * the worst case; but it never enumerates the vectors, and shared
+       * subtrees are counted once.
+       */
+      uint64_t closure_size (size_t root) {
+        std::vector<std::map<std::vector<size_t>, uint64_t>> memo (this->dim + 1);
+        const st_node& root_node = layers[0][root];
+        size_t* children = child_buffer + root_node.cbuffer_offset;
+        return count_below (std::vector<size_t> (children, children + root_node.numchild), 1,
+                            memo);
+      }
+
       /* Recursive domination check of given vector by vectors in the language of
        * the given tree root.
        *
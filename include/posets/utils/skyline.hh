@@ -0,0 +1,396 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include <posets/concepts.hh>
+
+/*
+ * Bulk computation of the maximal elements (a.k.a. skyline) of a set of
+ * vectors, without duplicates.  This is what every downset needs when it is
+ * built from a list of vectors, and is much cheaper than inserting the
+ * vectors one by one.
+ *
+ * Three algorithms are provided:
+ *  - skyline_bnl: block-nested-loop, the window-based approach of
+ *    vector_backed::insert; no preprocessing, best for small inputs.
+ *  - skyline_sfs: sort-filter-skyline, which sorts by decreasing sum of
+ *    components so that an element can only be dominated by elements that
+ *    come before it; the window then never shrinks.
+ *  - skyline_dc: a divide-and-conquer variant of Kung, Luccio, and
+ *    Preparata's algorithm, which is subquadratic in low dimension.
+ * skyline () picks one based on the size and dimension of the input.  For
+ * HashableVectors, duplicates are removed with a hash pass, and sorting is
+ * done on the sort keys.
+ */
+
+// Inputs of at most this size go to skyline_bnl.
+#ifndef SKYLINE_BNL_MAX_SIZE
+# define SKYLINE_BNL_MAX_SIZE 64UL
+#endif
+// Inputs of at most this dimension go to skyline_dc, others to skyline_sfs.
+#ifndef SKYLINE_DC_MAX_DIM
+# define SKYLINE_DC_MAX_DIM 8UL
+#endif
+// Base case size of the recursions of skyline_dc.
+#ifndef SKYLINE_DC_BASE_SIZE
+# define SKYLINE_DC_BASE_SIZE 32UL
+#endif
+
+namespace posets::utils {
+  namespace skyline_details {
+    template <Vector V>
+    std::vector<V> move_out (std::vector<V*>& ptrs) {
+      std::vector<V> res;
+      res.reserve (ptrs.size ());
+      for (auto* p : ptrs)
+        res.push_back (std::move (*p));
+      return res;
+    }
+
+    // Remove duplicates, keeping the first occurrence, in place.
+    template <HashableVector V>
+    void deduplicate (std::vector<V>& elements) {
+      auto hash = [] (const V* v) { return v->hash (); };
+      auto eq = [] (const V* v1, const V* v2) { return *v1 == *v2; };
+      std::unordered_set<const V*, decltype (hash), decltype (eq)> seen (elements.size (), hash,
+                                                                         eq);
+      // seen holds the elements kept so far, which do not move anymore.
+      size_t kept = 0;
+      for (size_t i = 0; i < elements.size (); ++i) {
+        if (seen.contains (&elements[i]))
+          continue;
+        if (kept != i)
+          elements[kept] = std::move (elements[i]);
+        seen.insert (&elements[kept++]);
+      }
+      elements.erase (elements.begin () + static_cast<ssize_t> (kept), elements.end ());
+    }
+
+    // Lexicographic order, largest first.  If u dominates v and u != v, then
+    // u comes before v in that order.
+    template <Vector V>
+    bool lex_greater (const V* v1, const V* v2) {
+      for (size_t i = 0; i < v1->size (); ++i) {
+        if ((*v1)[i] > (*v2)[i])
+          return true;
+        if ((*v1)[i] < (*v2)[i])
+          return false;
+      }
+      return false;
+    }
+
+    // Keep the elements of a range ordered so that dominating elements come
+    // first, in place; return the new end.
+    template <Vector V>
+    auto filter_sorted (typename std::vector<V*>::iterator begin,
+                        typename std::vector<V*>::iterator end) {
+      auto window_end = begin;
+      for (auto it = begin; it != end; ++it) {
+        const bool dominated = std::any_of (begin, window_end, [&it] (const V* w) {
+          return (*it)->partial_order (*w).leq ();
+        });
+        if (not dominated)
+          *window_end++ = *it;
+      }
+      return window_end;
+    }
+
+    // NOLINTBEGIN(misc-no-recursion)
+    // Flag in dominated the elements of bs that are dominated by an element of
+    // as, knowing that any a in as and b in bs satisfy a[i] >= b[i] for all i
+    // < dim.
+    template <Vector V>
+    void filter (std::vector<V*> as, std::vector<V*> bs, size_t dim, const V* base,
+                 std::vector<char>& dominated) {
+      std::erase_if (bs, [&] (const V* b) { return dominated[b - base]; });
+      if (as.empty () or bs.empty ())
+        return;
+      const size_t k = as[0]->size ();
+
+      if (dim == k) {  // All of bs is dominated.
+        for (auto* b : bs)
+          dominated[b - base] = true;
+        return;
+      }
+
+      if (as.size () * bs.size () <= SKYLINE_DC_BASE_SIZE * SKYLINE_DC_BASE_SIZE) {
+        for (auto* b : bs)
+          dominated[b - base] =
+              std::ranges::any_of (as, [&b] (const V* a) { return b->partial_order (*a).leq (); });
+        return;
+      }
+
+      auto at_dim = [dim] (const V* v) { return (*v)[dim]; };
+      auto amin = at_dim (*std::ranges::min_element (as, {}, at_dim));
+      auto bmax = at_dim (*std::ranges::max_element (bs, {}, at_dim));
+      if (amin >= bmax) {  // dim is settled.
+        filter (std::move (as), std::move (bs), dim + 1, base, dominated);
+        return;
+      }
+
+      // Split at a median value m along dim, making sure both sides of the
+      // split are nonempty.
+      std::vector<typename V::value_type> vals;
+      vals.reserve (as.size () + bs.size ());
+      for (auto* a : as)
+        vals.push_back ((*a)[dim]);
+      for (auto* b : bs)
+        vals.push_back ((*b)[dim]);
+      auto [vmin, vmax] = std::ranges::minmax (vals);
+      auto mid = vals.begin () + static_cast<ssize_t> (vals.size () / 2);
+      std::nth_element (vals.begin (), mid, vals.end ());
+      const auto m = std::clamp<typename V::value_type> (*mid, vmin, vmax - 1);
+
+      std::vector<V*> ahi, alo, bhi, blo;
+      for (auto* a : as)
+        ((*a)[dim] > m ? ahi : alo).push_back (a);
+      for (auto* b : bs)
+        ((*b)[dim] > m ? bhi : blo).push_back (b);
+
+      // The high part of bs can only be dominated by the high part of as,
+      // which in turn dominates the low part of bs along dim.
+      filter (ahi, std::move (bhi), dim, base, dominated);
+      filter (std::move (ahi), blo, dim + 1, base, dominated);
+      filter (std::move (alo), std::move (blo), dim, base, dominated);
+    }
+
+    // Compute the maximal elements of the lexicographically sorted range,
+    // moving them at its start; return the new end.
+    template <Vector V>
+    auto maxima (typename std::vector<V*>::iterator begin, typename std::vector<V*>::iterator end,
+                 const V* base, std::vector<char>& dominated) {
+      const auto length = std::distance (begin, end);
+      if (static_cast<size_t> (length) <= SKYLINE_DC_BASE_SIZE)
+        return filter_sorted<V> (begin, end);
+
+      // Elements of the first half can't be dominated by the second half,
+      // and they are at least as large along the first dimension.
+      auto mid = begin + (length / 2);
+      auto aend = maxima<V> (begin, mid, base, dominated);
+      auto bend = maxima<V> (mid, end, base, dominated);
+      filter (std::vector<V*> (begin, aend), std::vector<V*> (mid, bend), 1, base, dominated);
+      auto kept_end =
+          std::remove_if (mid, bend, [&] (const V* b) { return dominated[b - base]; });
+      if (aend == mid)
+        return kept_end;
+      return std::copy (mid, kept_end, aend);
+    }
+    // NOLINTEND(misc-no-recursion)
+  }
+
+  template <Vector V>
+  std::vector<V> skyline_bnl (std::vector<V>&& elements) {
+    std::vector<V*> window;
+    for (auto& e : elements) {
+      bool must_remove = false;
+      auto result = window.begin ();
+      bool dominated = false;
+      for (auto it = result; it != window.end (); ++it) {
+        auto po = e.partial_order (**it);
+        if (not must_remove and po.leq ()) {
+          dominated = true;
+          break;
+        }
+        if (po.geq ())
+          must_remove = true;
+        else
+          *result++ = *it;
+      }
+      if (dominated)
+        continue;
+      window.erase (result, window.end ());
+      window.push_back (&e);
+    }
+    return skyline_details::move_out (window);
+  }
+
+  template <Vector V>
+  std::vector<V> skyline_sfs (std::vector<V>&& elements) {
+    std::vector<long long> sums (elements.size ());
+    std::vector<V*> ptrs;
+    ptrs.reserve (elements.size ());
+    for (size_t i = 0; i < elements.size (); ++i) {
+      ptrs.push_back (&elements[i]);
+      for (size_t j = 0; j < elements[i].size (); ++j)
+        sums[i] += elements[i][j];
+    }
+    const V* base = elements.data ();
+    std::ranges::stable_sort (ptrs, std::greater<> (),
+                              [&sums, base] (const V* p) { return sums[p - base]; });
+    ptrs.erase (skyline_details::filter_sorted<V> (ptrs.begin (), ptrs.end ()), ptrs.end ());
+    return skyline_details::move_out (ptrs);
+  }
+
+  template <Vector V>
+  std::vector<V> skyline_dc (std::vector<V>&& elements) {
+    std::vector<V*> ptrs;
+    ptrs.reserve (elements.size ());
+    for (auto& e : elements)
+      ptrs.push_back (&e);
+    if constexpr (HashableVector<V>) {
+      // Sort on the keys, computed once, with memcmp.
+      const size_t key_size = elements.empty () ? 0 : elements[0].sort_key_size ();
+      std::vector<unsigned char> keys (elements.size () * key_size);
+      for (size_t i = 0; i < elements.size (); ++i)
+        elements[i].sort_key (std::span (keys.data () + (i * key_size), key_size));
+      auto key = [&] (const V* v) { return keys.data () + ((v - elements.data ()) * key_size); };
+
+      std::ranges::sort (ptrs, [&] (const V* v1, const V* v2) {
+        return std::memcmp (key (v1), key (v2), key_size) > 0;
+      });
+      ptrs.erase (std::unique (ptrs.begin (), ptrs.end (),
+                               [&] (const V* v1, const V* v2) {
+                                 return std::memcmp (key (v1), key (v2), key_size) == 0;
+                               }),
+                  ptrs.end ());
+    }
+    else {
+      std::ranges::sort (ptrs, skyline_details::lex_greater<V>);
+      ptrs.erase (std::unique (ptrs.begin (), ptrs.end (),
+                               [] (const V* v1, const V* v2) { return *v1 == *v2; }),
+                  ptrs.end ());
+    }
+
+    std::vector<char> dominated (elements.size (), false);
+    ptrs.erase (
+        skyline_details::maxima<V> (ptrs.begin (), ptrs.end (), elements.data (), dominated),
+        ptrs.end ());
+    return skyline_details::move_out (ptrs);
+  }
+
+  // The maximal elements of elements, without duplicates, in no particular
+  // order.
+  template <Vector V>
+  std::vector<V> skyline (std::vector<V>&& elements) {
+    if (elements.size () <= SKYLINE_BNL_MAX_SIZE)
+      return skyline_bnl (std::move (elements));
+    if (elements[0].size () <= SKYLINE_DC_MAX_DIM)
+      return skyline_dc (std::move (elements));
+    if constexpr (HashableVector<V>)
+      skyline_details::deduplicate (elements);
+    return skyline_sfs (std::move (elements));
+  }
+
+  /// Insert v in the antichain elements[from..), unless it is dominated by
+  /// one of its elements; the elements that v dominates are removed.  v is
+  /// only moved from if it is inserted, which is what is returned.
+  template <Vector V>
+  bool antichain_insert (std::vector<V>& elements, size_t from, V& v) {
+    bool must_remove = false;
+
+    // This is like remove_if, but allows breaking.
+    auto result = elements.begin () + static_cast<ssize_t> (from);
+    auto end = elements.end ();
+
+    for (auto it = result; it != end; ++it) {
+      auto res = v.partial_order (*it);
+      // Since we started with an antichain, v cannot be dominated once it
+      // dominates an element, and elements are only moved after that.
+      if (not must_remove and res.leq ())
+        return false;
+      if (res.geq ())
+        must_remove = true;
+      else {
+        if (result != it)
+          *result = std::move (*it);
+        ++result;
+      }
+    }
+
+    if (result != elements.end ())
+      elements.erase (result, elements.end ());
+    elements.push_back (std::move (v));
+    return true;
+  }
+
+  /// Append to out the maximal elements of the meets of x with the elements
+  /// of ys.  For LatticeVectors, each meet is computed in scratch, which is
+  /// only moved out when the meet is kept: discarded meets cost no
+  /// allocation.
+  template <Vector V, std::ranges::input_range R>
+  void append_meets (const V& x, const R& ys, std::vector<V>& out, std::optional<V>& scratch) {
+    const size_t from = out.size ();
+    for (const auto& y : ys) {
+      if constexpr (LatticeVector<V>) {
+        if (not scratch)
+          scratch.emplace (x.copy ());
+        V::meet_into (*scratch, x, y);
+        if (antichain_insert (out, from, *scratch))
+          scratch.reset ();
+      }
+      else {
+        auto m = x.meet (y);
+        antichain_insert (out, from, m);
+      }
+    }
+  }
+
+  namespace skyline_details {
+    // The number of vectors with components at least -1 below v.
+    template <Vector V>
+    uint64_t box_size (const V& v) {
+      uint64_t res = 1;
+      for (size_t i = 0; i < v.size (); ++i) {
+        if (v[i] < -1)
+          return 0;
+        res *= static_cast<uint64_t> (v[i] + 2);
+      }
+      return res;
+    }
+
+    // NOLINTBEGIN(misc-no-recursion)
+    // Inclusion-exclusion, one element at a time: each element counts the
+    // vectors below it that are not below a later element, that is, its box
+    // minus the closure of its meets with the later elements.  Only the
+    // maximal meets with a nonempty box are kept for the recursion.
+    template <Vector V>
+    uint64_t union_size (std::vector<V>& elements) {
+      // Going from the smallest boxes to the largest keeps the sets of meets
+      // small: a small box has few maximal meets with the others.  The size
+      // is only a sort key here, so a double is precise enough.
+      std::ranges::sort (elements, std::less<> (), [] (const V& v) {
+        double size = 1;
+        for (size_t i = 0; i < v.size (); ++i)
+          size *= v[i] + 2.;
+        return size;
+      });
+      uint64_t total = 0;
+      std::vector<V> meets;
+      std::optional<V> scratch;
+      for (size_t k = 0; k < elements.size (); ++k) {
+        total += box_size (elements[k]);
+        meets.clear ();
+        append_meets (elements[k], std::span (elements).subspan (k + 1), meets, scratch);
+        std::erase_if (meets, [] (const V& m) { return box_size (m) == 0; });
+        if (not meets.empty ())
+          total -= union_size (meets);
+      }
+      return total;
+    }
+    // NOLINTEND(misc-no-recursion)
+  }
+
+  /// The number of vectors with components at least -1 that are below some
+  /// element of the antichain, without enumerating them; if no component is
+  /// below -1, this is the size of the full_set it generates.  The count is
+  /// computed modulo 2^64, so it is exact whenever it fits in 64 bits.
+  template <std::ranges::input_range R>
+  uint64_t closure_size (const R& antichain) {
+    using V = std::ranges::range_value_t<R>;
+    std::vector<V> elements;
+    for (const auto& e : antichain)
+      elements.push_back (e.copy ());
+    if (elements.empty ())
+      return 0;
+    return skyline_details::union_size (elements);
+  }
+}
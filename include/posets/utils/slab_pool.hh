@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#ifdef __linux__
+# include <sys/mman.h>
+#endif
+
+// Size of the chunks of memory that pools carve objects from.  The default
+// is the size of a transparent huge page on x86-64.
+#ifndef SLAB_POOL_SLAB_SIZE
+# define SLAB_POOL_SLAB_SIZE (2UL << 20)
+#endif
+
+// If nonzero, ask the kernel to back slabs with transparent huge pages.
+#ifndef SLAB_POOL_HUGEPAGES
+# define SLAB_POOL_HUGEPAGES 0
+#endif
+
+namespace posets::utils {
+  /// A pool of fixed-size objects of Size bytes aligned on Align, carved from
+  /// large slabs.  Freed objects are put on a free list and reused first, so
+  /// that allocation and deallocation are a couple of pointer moves.  All the
+  /// memory is given back at once by release (), which makes a pool usable as
+  /// an arena: objects need not be deallocated one by one if the whole pool
+  /// is released.
+  ///
+  /// A pool is not thread-safe, and is meant to be used by one thread, with
+  /// one exception: an object may be deallocated by any thread.  Each slab
+  /// starts with a header naming the pool that owns it, and an object
+  /// deallocated through another pool is pushed on the remote free list of
+  /// its owner, which takes the whole list back when its own free list is
+  /// empty.  Objects thus always return to the pool they came from.
+  template <size_t Size, size_t Align>
+  class slab_pool {
+      struct free_slot {
+          free_slot* next;
+      };
+
+      using remote_list = std::atomic<free_slot*>;
+
+      struct slab_header {
+          const slab_pool* owner;
+          remote_list* remote;
+      };
+
+      static constexpr size_t slot_align = std::max (Align, alignof (void*));
+      static constexpr size_t slot_size =
+          (std::max (Size, sizeof (void*)) + slot_align - 1) / slot_align * slot_align;
+      static constexpr size_t header_size =
+          (sizeof (slab_header) + slot_align - 1) / slot_align * slot_align;
+      // Slabs are aligned on their size, so that the header of the slab of an
+      // object is found by masking its address.
+      static constexpr size_t slab_size =
+          std::bit_ceil (std::max ({SLAB_POOL_SLAB_SIZE, header_size + slot_size, 4096UL}));
+
+    public:
+      // If release_on_destruction is false, the slabs are never given back to
+      // the system unless release () is called explicitly, and neither is the
+      // remote free list.  This is used for thread-local pools, as objects
+      // may outlive the thread that allocated them, and be deallocated later.
+      slab_pool (bool release_on_destruction = true)
+        : release_on_destruction {release_on_destruction},
+          remote {new remote_list {nullptr}} {}
+
+      slab_pool (const slab_pool&) = delete;
+      slab_pool& operator= (const slab_pool&) = delete;
+
+      ~slab_pool () {
+        if (release_on_destruction) {
+          release ();
+          delete remote;
+        }
+      }
+
+      void* allocate () {
+        if (not free_list)
+          free_list = remote->exchange (nullptr, std::memory_order_acquire);
+        if (free_list) {
+          auto* slot = free_list;
+          free_list = slot->next;
+          return slot;
+        }
+        if (cur == cur_end)
+          new_slab ();
+        void* slot = cur;
+        cur += slot_size;
+        return slot;
+      }
+
+      void deallocate (void* p) {
+        auto* slot = static_cast<free_slot*> (p);
+        const auto* header = reinterpret_cast<const slab_header*> (
+            reinterpret_cast<uintptr_t> (p) & ~(uintptr_t {slab_size} - 1));
+        if (header->owner == this) {
+          slot->next = free_list;
+          free_list = slot;
+          return;
+        }
+        auto& list = *header->remote;
+        slot->next = list.load (std::memory_order_relaxed);
+        while (not list.compare_exchange_weak (slot->next, slot, std::memory_order_release,
+                                               std::memory_order_relaxed))
+          ;
+      }
+
+      // Give all the slabs back to the system; everything allocated from the
+      // pool becomes invalid.
+      void release () {
+        for (auto* slab : slabs)
+          std::free (slab);
+        slabs.clear ();
+        free_list = nullptr;
+        remote->store (nullptr, std::memory_order_relaxed);
+        cur = cur_end = nullptr;
+      }
+
+      [[nodiscard]] size_t nslabs () const { return slabs.size (); }
+
+    private:
+      void new_slab () {
+        void* slab = std::aligned_alloc (slab_size, slab_size);
+        if (slab == nullptr)
+          throw std::bad_alloc ();
+#if defined(__linux__) and SLAB_POOL_HUGEPAGES
+        madvise (slab, slab_size, MADV_HUGEPAGE);
+#endif
+        new (slab) slab_header {this, remote};
+        slabs.push_back (slab);
+        cur = static_cast<char*> (slab) + header_size;
+        cur_end = cur + ((slab_size - header_size) / slot_size * slot_size);
+      }
+
+      bool release_on_destruction;
+      remote_list* remote;
+      free_slot* free_list = nullptr;
+      char* cur = nullptr;
+      char* cur_end = nullptr;
+      std::vector<void*> slabs;
+  };
+}
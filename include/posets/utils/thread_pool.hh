@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads of the global pool, including the calling thread; 0 means
+// one per hardware thread, and 1 runs everything on the calling thread.
+#ifndef POSETS_THREADS
+# define POSETS_THREADS 0
+#endif
+
+namespace posets::utils {
+  /// A fork-join pool of worker threads.  Work is handed out as batches of
+  /// numbered tasks; the calling thread takes part in its batch, and while it
+  /// waits for the other tasks, it runs whatever work is queued.  Batches can
+  /// thus be nested, e.g., in a recursive divide and conquer, without
+  /// blocking the pool.
+  ///
+  /// Tasks must not throw.  The results of a batch are the caller's concern;
+  /// writing them at the index of the task keeps them deterministic.
+  class thread_pool {
+    public:
+      thread_pool (size_t nthreads) {
+        for (size_t i = 1; i < nthreads; ++i)
+          workers.emplace_back ([this] { work (); });
+      }
+
+      thread_pool (const thread_pool&) = delete;
+      thread_pool& operator= (const thread_pool&) = delete;
+
+      ~thread_pool () {
+        {
+          std::lock_guard lock {mutex};
+          stopping = true;
+        }
+        wake.notify_all ();
+        for (auto& w : workers)
+          w.join ();
+      }
+
+      /// The pool shared by the library, with POSETS_THREADS threads.
+      static thread_pool& global () {
+        static thread_pool pool {POSETS_THREADS != 0
+                                     ? POSETS_THREADS
+                                     : std::max (1U, std::thread::hardware_concurrency ())};
+        return pool;
+      }
+
+      /// The number of threads, including the calling one.
+      [[nodiscard]] size_t size () const { return workers.size () + 1; }
+
+      /// Call task (i) for each i in [0, ntasks), in parallel, and return when
+      /// they are all done.
+      template <typename F>
+      void run (size_t ntasks, const F& task) {
+        if (workers.empty () or ntasks <= 1) {
+          for (size_t i = 0; i < ntasks; ++i)
+            task (i);
+          return;
+        }
+
+        // The helpers posted to the queue grab task numbers until there are
+        // none left.  They refer to this frame, so we wait for all of them
+        // to finish, including those that start after the last task is done.
+        std::atomic<size_t> next {0};
+        std::atomic<size_t> finished {0};
+        const size_t nhelpers = std::min (workers.size (), ntasks - 1);
+        auto grab = [&] {
+          for (size_t i = next++; i < ntasks; i = next++)
+            task (i);
+        };
+        {
+          std::lock_guard lock {mutex};
+          for (size_t h = 0; h < nhelpers; ++h)
+            queue.emplace_back ([&] {
+              grab ();
+              finished.fetch_add (1, std::memory_order_release);
+            });
+        }
+        wake.notify_all ();
+
+        grab ();
+        while (finished.load (std::memory_order_acquire) < nhelpers)
+          if (not run_one ())
+            std::this_thread::yield ();
+      }
+
+      /// Call f () and g (), possibly in parallel, and return when both are
+      /// done.
+      template <typename F, typename G>
+      void invoke (const F& f, const G& g) {
+        run (2, [&] (size_t i) {
+          if (i == 0)
+            f ();
+          else
+            g ();
+        });
+      }
+
+      /// Call f (begin, end) over consecutive chunks of [0, n), in parallel.
+      /// The chunks have at least grain indices, and there are a few per
+      /// thread.
+      template <typename F>
+      void for_chunks (size_t n, size_t grain, const F& f) {
+        grain = std::max (grain, (n + (4 * size ()) - 1) / (4 * size ()));
+        grain = std::max<size_t> (grain, 1);
+        run ((n + grain - 1) / grain,
+             [&] (size_t c) { f (c * grain, std::min (n, (c + 1) * grain)); });
+      }
+
+    private:
+      // Run one queued job, if any.
+      bool run_one () {
+        std::function<void ()> job;
+        {
+          std::lock_guard lock {mutex};
+          if (queue.empty ())
+            return false;
+          job = std::move (queue.front ());
+          queue.pop_front ();
+        }
+        job ();
+        return true;
+      }
+
+      void work () {
+        while (true) {
+          std::function<void ()> job;
+          {
+            std::unique_lock lock {mutex};
+            wake.wait (lock, [this] { return stopping or not queue.empty (); });
+            if (queue.empty ())
+              return;
+            job = std::move (queue.front ());
+            queue.pop_front ();
+          }
+          job ();
+        }
+      }
+
+      std::vector<std::thread> workers;
+      std::mutex mutex;
+      std::condition_variable wake;
+      std::deque<std::function<void ()>> queue;
+      bool stopping = false;
+  };
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+#include <posets/concepts.hh>
+
+/*
+ * A hash-consing store of vectors: each distinct vector is stored once, and
+ * named by a 32-bit id.  Ids are reference counted; a vector is dropped from
+ * the store when its last reference is released, and its id is then reused.
+ *
+ * Downsets holding ids (see downsets/interned_backed.hh) share the vectors of
+ * a store, and compare equal vectors by comparing ids.  A store is not
+ * thread-safe; by default, each thread has its own, see current ().
+ */
+
+namespace posets::utils {
+  template <HashableVector V>
+  class vector_store {
+    public:
+      using id_t = uint32_t;
+
+      vector_store () = default;
+      // The index refers to this, so the store does not move.
+      vector_store (const vector_store&) = delete;
+      vector_store& operator= (const vector_store&) = delete;
+
+      /// The id of v, which is stored if it is new.  The reference count of
+      /// the id is incremented.
+      id_t intern (V&& v) {
+        if (auto id = find (v)) {
+          ++refs[*id];
+          return *id;
+        }
+        return add (std::move (v));
+      }
+
+      /// Same, but v is only copied if it is new.
+      id_t intern (const V& v) {
+        if (auto id = find (v)) {
+          ++refs[*id];
+          return *id;
+        }
+        return add (v.copy ());
+      }
+
+      /// The id of v, if it is stored.
+      [[nodiscard]] std::optional<id_t> find (const V& v) const {
+        auto it = index.find (v);
+        if (it == index.end ())
+          return std::nullopt;
+        return *it;
+      }
+
+      void acquire (id_t id) {
+        assert (refs[id] > 0);
+        ++refs[id];
+      }
+
+      void release (id_t id) {
+        assert (refs[id] > 0);
+        if (--refs[id] == 0) {
+          index.erase (id);
+          vectors[id].reset ();
+          free_ids.push_back (id);
+        }
+      }
+
+      [[nodiscard]] const V& operator[] (id_t id) const {
+        assert (vectors[id]);
+        return *vectors[id];
+      }
+
+      /// The number of distinct vectors stored.
+      [[nodiscard]] size_t size () const { return index.size (); }
+
+      [[nodiscard]] size_t references (id_t id) const { return refs[id]; }
+
+      /// Iterates over an array of ids, yielding the vectors they name.
+      class const_iterator {
+        public:
+          using iterator_category = std::forward_iterator_tag;
+          using value_type = V;
+          using difference_type = std::ptrdiff_t;
+          using pointer = const V*;
+          using reference = const V&;
+
+          const_iterator () = default;
+          const_iterator (const vector_store* store, const id_t* id) : store {store}, id {id} {}
+
+          reference operator* () const { return (*store)[*id]; }
+          pointer operator->() const { return &(*store)[*id]; }
+
+          const_iterator& operator++ () {
+            ++id;
+            return *this;
+          }
+
+          const_iterator operator++ (int) {
+            auto res = *this;
+            ++id;
+            return res;
+          }
+
+          bool operator== (const const_iterator& other) const { return id == other.id; }
+
+        private:
+          const vector_store* store = nullptr;
+          const id_t* id = nullptr;
+      };
+
+      /// The store used by default by the downsets of this thread, or the
+      /// one set by the innermost live scope.
+      static std::shared_ptr<vector_store> current () {
+        if (auto& s = scoped ())
+          return s;
+        thread_local auto global = std::make_shared<vector_store> ();
+        return global;
+      }
+
+      /// Make a store the current one while this lives, e.g., for one
+      /// fixpoint computation.
+      class scope {
+        public:
+          scope (std::shared_ptr<vector_store> store) : previous {std::move (scoped ())} {
+            scoped () = std::move (store);
+          }
+          scope (const scope&) = delete;
+          scope& operator= (const scope&) = delete;
+          ~scope () { scoped () = std::move (previous); }
+
+        private:
+          std::shared_ptr<vector_store> previous;
+      };
+
+    private:
+      static std::shared_ptr<vector_store>& scoped () {
+        thread_local std::shared_ptr<vector_store> s;
+        return s;
+      }
+
+      id_t add (V&& v) {
+        id_t id;
+        if (free_ids.empty ()) {
+          id = static_cast<id_t> (vectors.size ());
+          hashes.push_back (v.hash ());
+          vectors.emplace_back (std::move (v));
+          refs.push_back (1);
+        }
+        else {
+          id = free_ids.back ();
+          free_ids.pop_back ();
+          hashes[id] = v.hash ();
+          vectors[id].emplace (std::move (v));
+          refs[id] = 1;
+        }
+        index.insert (id);
+        return id;
+      }
+
+      // Ids are hashed and compared through the store, and can be looked up
+      // with the vector they name.
+      struct id_hash {
+          using is_transparent = void;
+          const vector_store* store;
+          size_t operator() (id_t id) const { return store->hashes[id]; }
+          size_t operator() (const V& v) const { return v.hash (); }
+      };
+
+      struct id_equal {
+          using is_transparent = void;
+          const vector_store* store;
+          bool operator() (id_t a, id_t b) const { return a == b; }
+          bool operator() (id_t a, const V& b) const { return (*store)[a] == b; }
+          bool operator() (const V& a, id_t b) const { return a == (*store)[b]; }
+      };
+
+      std::vector<std::optional<V>> vectors;
+      std::vector<size_t> hashes;
+      std::vector<uint32_t> refs;
+      std::vector<id_t> free_ids;
+      std::unordered_set<id_t, id_hash, id_equal> index {0, id_hash {this}, id_equal {this}};
+  };
+}
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <posets/concepts.hh>
+#include <posets/vectors/X_and_bits.hh>
 #include <posets/vectors/X_and_bitset.hh>
 #include <posets/vectors/generic.hh>
+#include <posets/vectors/packed.hh>
+#include <posets/vectors/sparse.hh>
 
 namespace posets::vectors {
 
@@ -24,6 +27,14 @@ namespace posets::vectors {
   template <typename T, size_t K>
   using simd_array_ptr_backed_sum = generic<simd_array_t<T, K>, true, false>;
 
+  // Vectors with a dominance signature compare the average of groups of
+  // components to SignatureStep times powers of two; see signature_member.
+  template <typename T, size_t K, long SignatureStep = 1>
+  using simd_array_ptr_backed_sig = generic<simd_array_t<T, K>, false, false, SignatureStep>;
+
+  template <typename T, size_t K>
+  using simd_array_ptr_backed_slab = generic<simd_array_t<T, K>, false, false, 0, slab_malloc>;
+
   template <typename T>
   using simd_vector_t = std::vector<typename utils::simd_traits<T>::fssimd>;
 
@@ -35,6 +46,9 @@ namespace posets::vectors {
   template <typename T>
   using simd_vector_backed_sum = generic<simd_vector_t<T>, true, true>;
 
+  template <typename T, long SignatureStep = 1>
+  using simd_vector_backed_sig = generic<simd_vector_t<T>, false, true, SignatureStep>;
+
 #define ITEMS_PER_BLOCK 8
 
   template <typename T, size_t K>
@@ -55,6 +69,9 @@ namespace posets::vectors {
   template <typename T, size_t K>
   using array_ptr_backed_sum = generic<array_t<T, K>, true, false>;
 
+  template <typename T, size_t K>
+  using array_ptr_backed_slab = generic<array_t<T, K>, false, false, 0, slab_malloc>;
+
   template <typename T>
   using vector_t = std::vector<std::array<T, ITEMS_PER_BLOCK>>;
 
@@ -90,17 +107,48 @@ namespace posets::vectors {
   static_assert (Vector<simd_array_backed_sum<int, 128>>);
   static_assert (Vector<simd_array_ptr_backed<int, 128>>);
   static_assert (Vector<simd_array_ptr_backed_sum<int, 128>>);
+  static_assert (Vector<simd_array_ptr_backed_slab<int, 128>>);
+  static_assert (Vector<simd_array_ptr_backed_sig<int, 128>>);
   static_assert (Vector<simd_vector_backed<int>>);
   static_assert (Vector<simd_vector_backed_sum<int>>);
+  static_assert (Vector<simd_vector_backed_sig<int>>);
 
   static_assert (Vector<array_backed<int, 128>>);
   static_assert (Vector<array_backed_sum<int, 128>>);
   static_assert (Vector<array_ptr_backed<int, 128>>);
   static_assert (Vector<array_ptr_backed_sum<int, 128>>);
+  static_assert (Vector<array_ptr_backed_slab<int, 128>>);
   static_assert (Vector<vector_backed<int>>);
   static_assert (Vector<vector_backed_sum<int>>);
 
   static_assert (Vector<x_and_bitset<vector_backed<int>, 128>>);
+  static_assert (Vector<x_and_bits<vector_backed<int>>>);
+  static_assert (Vector<x_and_bits<simd_vector_backed<int>, fixed_bitset_split<64>>>);
+
+  static_assert (Vector<packed<char, 2>>);
+  static_assert (Vector<packed<char, 4>>);
+  static_assert (Vector<packed<unsigned char, 8>>);
+
+  static_assert (Vector<sparse<char>>);
+  static_assert (Vector<sparse<int>>);
+
+  static_assert (HashableVector<simd_array_backed<int, 128>>);
+  static_assert (HashableVector<array_ptr_backed_sum<int, 128>>);
+  static_assert (HashableVector<vector_backed<int>>);
+  static_assert (HashableVector<x_and_bitset<vector_backed<int>, 128>>);
+  static_assert (HashableVector<x_and_bits<vector_backed<int>>>);
+  static_assert (HashableVector<packed<char, 4>>);
+  static_assert (HashableVector<sparse<char>>);
+
+  static_assert (LatticeVector<simd_array_backed<int, 128>>);
+  static_assert (LatticeVector<array_ptr_backed_slab<int, 128>>);
+  static_assert (LatticeVector<simd_vector_backed_sig<int>>);
+  static_assert (LatticeVector<vector_backed<int>>);
+  static_assert (LatticeVector<x_and_bitset<vector_backed<int>, 128>>);
+  static_assert (LatticeVector<x_and_bitset<vector_backed<int>, 0>>);
+  static_assert (LatticeVector<x_and_bits<vector_backed<int>>>);
+  static_assert (LatticeVector<packed<char, 4>>);
+  static_assert (LatticeVector<sparse<char>>);
 }
 
 namespace std {
@@ -108,4 +156,9 @@ namespace std {
   inline std::ostream& operator<< (std::ostream& os, const V& v) {
     return v.print (os);
   }
+
+  template <posets::HashableVector V>
+  struct hash<V> {
+      size_t operator() (const V& v) const { return v.hash (); }
+  };
 }
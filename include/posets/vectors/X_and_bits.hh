@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <span>
+
+#include <posets/concepts.hh>
+#include <posets/utils/vector_mm.hh>
+#include <posets/vectors/generic_kernels.hh>
+#include <posets/vectors/traits.hh>
+
+namespace posets::vectors {
+  /// Where x_and_bits splits a vector of size k: the components before at (k)
+  /// go to X, the others are booleans.  This one follows the global
+  /// bitset_threshold, as x_and_bitset does.
+  struct global_bitset_split {
+      static size_t at (size_t k) { return std::min (bitset_threshold, k); }
+  };
+
+  /// A split point fixed by the vector type.
+  template <size_t Threshold>
+  struct fixed_bitset_split {
+      static size_t at (size_t k) { return std::min (Threshold, k); }
+  };
+
+  /// Like x_and_bitset, but the booleans live in a runtime-sized array of
+  /// 64-bit words, so that one type serves any number of booleans.  The
+  /// split point is given by the Split policy, or per vector at construction
+  /// (e.g., by the code building the elements of a downset); it is then kept
+  /// by copy and meet.  Vectors that are compared should share it.
+  ///
+  /// As in x_and_bitset, a boolean component is -1 (false) or 0 (true).
+  template <typename X, typename Split = global_bitset_split>
+  class x_and_bits {
+      using word_t = uint64_t;
+      using words_t = utils::vector_mm<word_t>;
+
+      static constexpr size_t bits_per_word = sizeof (word_t) * 8;
+
+      // Words come by chunks of 64 bytes, so that the kernels have no tail.
+      static constexpr size_t words_per_chunk = 64 / sizeof (word_t);
+
+      static constexpr size_t words_for (size_t nbools) {
+        const size_t nwords = (nbools + bits_per_word - 1) / bits_per_word;
+        return (nwords + words_per_chunk - 1) / words_per_chunk * words_per_chunk;
+      }
+
+    public:
+      using value_type = typename X::value_type;
+
+      x_and_bits (size_t k) : x_and_bits (k, Split::at (k)) {}
+
+      x_and_bits (size_t k, size_t split) : k {k}, x (split), words (words_for (k - split), 0) {
+        assert (split <= k);
+      }
+
+      x_and_bits (std::span<const value_type> v) : x_and_bits (v, Split::at (v.size ())) {}
+
+      x_and_bits (std::span<const value_type> v, size_t split)
+        : k {v.size ()},
+          x (v.first (split)),
+          words (words_for (k - split), 0) {
+        for (size_t i = split; i < k; ++i) {
+          assert (v[i] == -1 or v[i] == 0);
+          if (v[i] + 1)
+            words[(i - split) / bits_per_word] |= word_t {1} << ((i - split) % bits_per_word);
+        }
+        sum = kernels::popcount (words.data (), words.size ());
+      }
+
+      x_and_bits (std::initializer_list<value_type> v)
+        : x_and_bits (std::span (v.begin (), v.size ())) {}
+
+      x_and_bits (x_and_bits&& other) = default;
+
+    private:
+      x_and_bits (size_t k, X&& x, words_t&& words, size_t sum)
+        : k {k},
+          x {std::move (x)},
+          words {std::move (words)},
+          sum {sum} {
+        assert (sum == kernels::popcount (this->words.data (), this->words.size ()));
+      }
+
+    public:
+      // explicit copy operator
+      [[nodiscard]] x_and_bits copy () const {
+        return x_and_bits (k, x.copy (), words_t (words), sum);
+      }
+
+      x_and_bits& operator= (x_and_bits&& other) = default;
+
+      x_and_bits& operator= (const x_and_bits& other) = delete;
+
+      [[nodiscard]] size_t size () const { return k; }
+
+      /// The number of components stored in X.
+      [[nodiscard]] size_t split () const { return x.size (); }
+
+      void to_vector (std::span<value_type> v) const {
+        x.to_vector (v.first (split ()));
+        for (size_t i = split (); i < k; ++i)
+          v[i] = (*this)[i];
+      }
+
+      class po_res {
+        public:
+          po_res (const x_and_bits& lhs, const x_and_bits& rhs) {
+            // As in x_and_bitset, the booleans are compared first.
+            bgeq = (lhs.sum >= rhs.sum);
+            bleq = (lhs.sum <= rhs.sum);
+
+            kernels::superset_subset (lhs.words.data (), rhs.words.data (), lhs.words.size (),
+                                      bgeq, bleq);
+
+            if (not bgeq and not bleq)
+              return;
+
+            auto po = lhs.x.partial_order (rhs.x);
+            bgeq = bgeq and po.geq ();
+            bleq = bleq and po.leq ();
+          }
+
+          bool geq () { return bgeq; }
+
+          bool leq () { return bleq; }
+
+        private:
+          bool bgeq, bleq;
+      };
+
+      [[nodiscard]] auto partial_order (const x_and_bits& rhs) const {
+        assert (rhs.k == k and rhs.split () == split ());
+        return po_res (*this, rhs);
+      }
+
+      bool operator== (const x_and_bits& rhs) const {
+        return sum == rhs.sum and words == rhs.words and x == rhs.x;
+      }
+
+      bool operator!= (const x_and_bits& rhs) const { return not (*this == rhs); }
+
+      value_type operator[] (size_t i) const {
+        if (i >= split ()) {
+          const size_t j = i - split ();
+          const auto bit = (words[j / bits_per_word] >> (j % bits_per_word)) & 1;
+          return static_cast<value_type> (bit) - 1;
+        }
+        return x[i];
+      }
+
+      [[nodiscard]] size_t hash () const
+        requires HashableVector<X>
+      {
+        return x.hash () ^ (kernels::hash (words.data (), words.size ()) * 0x9E3779B97F4A7C15ULL);
+      }
+
+      [[nodiscard]] size_t sort_key_size () const
+        requires HashableVector<X>
+      {
+        return x.sort_key_size () + ((k - split () + 7) / 8);
+      }
+
+      // The key of x followed by the booleans, most significant bit first.
+      void sort_key (std::span<unsigned char> key) const
+        requires HashableVector<X>
+      {
+        assert (key.size () >= sort_key_size ());
+        const size_t xsize = x.sort_key_size ();
+        x.sort_key (key.first (xsize));
+        std::fill (key.begin () + xsize, key.begin () + sort_key_size (), 0);
+        for (size_t i = 0; i < k - split (); ++i)
+          if ((words[i / bits_per_word] >> (i % bits_per_word)) & 1)
+            key[xsize + (i / 8)] |= 0x80 >> (i % 8);
+      }
+
+      [[nodiscard]] x_and_bits meet (const x_and_bits& rhs) const {
+        assert (rhs.k == k and rhs.split () == split ());
+        words_t res (words.size ());
+        kernels::bits_and (words.data (), rhs.words.data (), res.data (), words.size ());
+        const size_t res_sum = kernels::popcount (res.data (), res.size ());
+        return x_and_bits (k, x.meet (rhs.x), std::move (res), res_sum);
+      }
+
+      static void meet_into (x_and_bits& dst, const x_and_bits& a, const x_and_bits& b)
+        requires LatticeVector<X>
+      {
+        assert (a.k == b.k and dst.k == a.k and a.split () == b.split ());
+        assert (dst.split () == a.split ());
+        X::meet_into (dst.x, a.x, b.x);
+        kernels::bits_and (a.words.data (), b.words.data (), dst.words.data (), a.words.size ());
+        dst.sum = kernels::popcount (dst.words.data (), dst.words.size ());
+      }
+
+      void meet_assign (const x_and_bits& rhs)
+        requires LatticeVector<X>
+      {
+        meet_into (*this, *this, rhs);
+      }
+
+      [[nodiscard]] x_and_bits join (const x_and_bits& rhs) const
+        requires LatticeVector<X>
+      {
+        auto res = copy ();
+        res.join_assign (rhs);
+        return res;
+      }
+
+      void join_assign (const x_and_bits& rhs)
+        requires LatticeVector<X>
+      {
+        assert (rhs.k == k and rhs.split () == split ());
+        x.join_assign (rhs.x);
+        kernels::bits_or (words.data (), rhs.words.data (), words.data (), words.size ());
+        sum = kernels::popcount (words.data (), words.size ());
+      }
+
+      // Used by Sets, should be a total order.  Do not use.
+      bool operator< (const x_and_bits& rhs) const {
+        if (words == rhs.words)
+          return x < rhs.x;
+        return kernels::less (words.data (), rhs.words.data (), words.size ());
+      }
+
+      [[nodiscard]] auto bin () const {
+        // As in x_and_bitset, the number of true booleans is a valid bin on
+        // its own.
+        auto bits_bin = sum;
+        if constexpr (has_bin<X>::value)
+          bits_bin += x.bin ();
+        return bits_bin;
+      }
+
+      std::ostream& print (std::ostream& os) const {
+        os << "{ ";
+        for (size_t i = 0; i < this->size (); ++i)
+          os << (int) (*this)[i] << " ";
+        os << "}";
+        return os;
+      }
+
+    private:
+      size_t k;
+      X x;
+      words_t words;
+      size_t sum;  // The number of true booleans.
+  };
+}
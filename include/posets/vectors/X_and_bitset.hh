@@ -1,5 +1,7 @@
 #pragma once
+#include <algorithm>
 #include <bitset>
+#include <span>
 
 #include <posets/concepts.hh>
 #include <posets/utils/vector_mm.hh>
@@ -125,11 +127,67 @@ namespace posets::vectors {
         return x[i];
       }
 
+      [[nodiscard]] size_t hash () const
+        requires HashableVector<X>
+      {
+        return x.hash () ^ (std::hash<std::bitset<Bools>> () (bools) * 0x9E3779B97F4A7C15ULL);
+      }
+
+      [[nodiscard]] size_t sort_key_size () const
+        requires HashableVector<X>
+      {
+        return x.sort_key_size () + ((k - x.size () + 7) / 8);
+      }
+
+      // The key of x followed by the booleans, most significant bit first.
+      void sort_key (std::span<unsigned char> key) const
+        requires HashableVector<X>
+      {
+        assert (key.size () >= sort_key_size ());
+        const size_t xsize = x.sort_key_size ();
+        x.sort_key (key.first (xsize));
+        std::fill (key.begin () + xsize, key.begin () + sort_key_size (), 0);
+        for (size_t i = 0; i < k - x.size (); ++i)
+          if (bools[i])
+            key[xsize + (i / 8)] |= 0x80 >> (i % 8);
+      }
+
       [[nodiscard]] x_and_bitset meet (const x_and_bitset& rhs) const {
         assert (rhs.k == k);
         return x_and_bitset (k, x.meet (rhs.x), bools bitand rhs.bools);
       }
 
+      static void meet_into (x_and_bitset& dst, const x_and_bitset& a, const x_and_bitset& b)
+        requires LatticeVector<X>
+      {
+        assert (a.k == b.k and dst.k == a.k);
+        X::meet_into (dst.x, a.x, b.x);
+        dst.bools = a.bools bitand b.bools;
+        dst.sum = dst.bools.count ();
+      }
+
+      void meet_assign (const x_and_bitset& rhs)
+        requires LatticeVector<X>
+      {
+        meet_into (*this, *this, rhs);
+      }
+
+      [[nodiscard]] x_and_bitset join (const x_and_bitset& rhs) const
+        requires LatticeVector<X>
+      {
+        assert (rhs.k == k);
+        return x_and_bitset (k, x.join (rhs.x), bools bitor rhs.bools);
+      }
+
+      void join_assign (const x_and_bitset& rhs)
+        requires LatticeVector<X>
+      {
+        assert (rhs.k == k);
+        x.join_assign (rhs.x);
+        bools |= rhs.bools;
+        sum = bools.count ();
+      }
+
       bool operator< (const x_and_bitset& rhs) const {
         int cmp = std::memcmp (&bools, &rhs.bools, sizeof (bools));
         if (cmp == 0)
@@ -173,5 +231,10 @@ namespace posets::vectors {
       x_and_bitset (X&& x) : X (std::move (x)) {}
       x_and_bitset copy () const { return X::copy (); }
       x_and_bitset meet (const x_and_bitset& other) const { return X::meet (other); }
+      x_and_bitset join (const x_and_bitset& other) const
+        requires LatticeVector<X>
+      {
+        return X::join (other);
+      }
   };
 }
@@ -4,6 +4,8 @@
 #include <cstring>
 #include <experimental/simd>
 #include <iostream>
+#include <span>
+#include <type_traits>
 
 #include <posets/concepts.hh>
 #include <posets/utils/simd_traits.hh>
@@ -11,9 +13,12 @@
 #include <posets/vectors/generic_partial_order.hh>
 
 namespace posets::vectors {
-  template <typename Data, bool HasSum, bool EmbedsData>
+  template <typename Data, bool HasSum, bool EmbedsData, long SignatureStep = 0,
+            template <typename> typename Malloc = basic_malloc>
     requires HasData<Data>
-  class generic : private sum_member<HasSum>, private malloc_member<EmbedsData, Data> {
+  class generic : private sum_member<HasSum>,
+                  private signature_member<SignatureStep>,
+                  private malloc_member<EmbedsData, Data, Malloc> {
     public:
       using block_type = typename Data::value_type;
       using value_type = block_type::value_type;
@@ -21,6 +26,8 @@ namespace posets::vectors {
 
       static const auto items_per_block = sizeof (block_type) / sizeof (value_type);
 
+      static constexpr bool has_signature = SignatureStep != 0;
+
       static constexpr size_t blocks_for (size_t nelts) {
         return (nelts + items_per_block - 1) / items_per_block;
       }
@@ -52,6 +59,13 @@ namespace posets::vectors {
           return datap->size ();
       }
 
+      // All the components, including the zero padding of the last block.
+      [[nodiscard]] const value_type* values () const {
+        return reinterpret_cast<const value_type*> (data ());
+      }
+
+      [[nodiscard]] size_t padded_size () const { return data_size () * items_per_block; }
+
       void clear_back () {
         if (data_size () > blocks_for (k) or k % items_per_block) {
           char* start = reinterpret_cast<char*> (data () + (k / items_per_block));
@@ -85,6 +99,8 @@ namespace posets::vectors {
         }
         std::memcpy (reinterpret_cast<value_type*> (data ()), v.data (),
                      v.size () * sizeof (value_type));
+        if constexpr (has_signature)
+          this->compute_signature (v.data (), k);
       }
 
       generic () = delete;
@@ -94,6 +110,8 @@ namespace posets::vectors {
           other.datap = nullptr;
         if constexpr (HasSum)
           this->sum = other.sum;
+        if constexpr (has_signature)
+          this->signature = other.signature;
       }
 
       ~generic () {
@@ -109,6 +127,8 @@ namespace posets::vectors {
           res.datap = datap;
           if constexpr (HasSum)
             res.sum = this->sum;
+          if constexpr (has_signature)
+            res.signature = this->signature;
           return res;
         }
         else {
@@ -129,6 +149,8 @@ namespace posets::vectors {
           other.datap = nullptr;
         if constexpr (HasSum)
           this->sum = other.sum;
+        if constexpr (has_signature)
+          this->signature = other.signature;
 
         return *this;
       }
@@ -149,6 +171,9 @@ namespace posets::vectors {
         if constexpr (HasSum)
           if (this->sum != rhs.sum)
             return false;
+        if constexpr (has_signature)
+          if (this->signature != rhs.signature)
+            return false;
         // Trust memcmp to DTRT
         return std::memcmp (rhs.data (), data (), k * sizeof (value_type)) == 0;
       }
@@ -157,59 +182,66 @@ namespace posets::vectors {
         if constexpr (HasSum)
           if (this->sum != rhs.sum)
             return true;
+        if constexpr (has_signature)
+          if (this->signature != rhs.signature)
+            return true;
         // Trust memcmp to DTRT
         return std::memcmp (rhs.data (), data (), k * sizeof (value_type)) != 0;
       }
 
-      // Used by Sets, should be a total order.  Do not use.
+      // Used by Sets, should be a total order.  Do not use.  This is the
+      // lexicographical order.
       bool operator< (const generic& rhs) const {
-        for (size_t i = 0; i < data_size (); ++i) {
-          if constexpr (uses_simd) {
-            auto lhs_lt_rhs = data ()[i] < rhs.data ()[i];
-            auto rhs_lt_lhs = rhs.data ()[i] < data ()[i];
-            auto p1 = find_first_set (lhs_lt_rhs);
-            auto p2 = find_first_set (rhs_lt_lhs);
-            if (p1 == p2)
-              continue;
-            return (p1 < p2);
-          }
-          else {
-            // This is the lexicographical order.
-            auto order = data ()[i] <=> rhs.data ()[i];
-            if (order == std::weak_ordering::equivalent)
-              continue;
-            return order == std::weak_ordering::less;
-          }
+        return kernels::less (values (), rhs.values (), padded_size ());
+      }
+
+      [[nodiscard]] size_t hash () const { return kernels::hash (values (), padded_size ()); }
+
+      [[nodiscard]] size_t sort_key_size () const { return k * sizeof (value_type); }
+
+      // Components are written big-endian, with the sign bit flipped, so that
+      // memcmp orders them as numbers.
+      void sort_key (std::span<unsigned char> key) const {
+        using uvalue_type = std::make_unsigned_t<value_type>;
+        constexpr size_t nbytes = sizeof (value_type);
+        assert (key.size () >= sort_key_size ());
+        for (size_t i = 0; i < k; ++i) {
+          auto u = static_cast<uvalue_type> (at (i));
+          if constexpr (std::is_signed_v<value_type>)
+            u ^= uvalue_type {1} << ((nbytes * 8) - 1);
+          for (size_t b = 0; b < nbytes; ++b)
+            key[(i * nbytes) + b] = static_cast<unsigned char> (u >> ((nbytes - 1 - b) * 8));
         }
-        return false;
       }
 
       [[nodiscard]] generic meet (const generic& rhs) const {
         auto res = generic (k);
-        if constexpr (not EmbedsData)
-          res.datap = this->malloc.construct ();
-
-        for (size_t i = 0; i < data_size (); ++i) {
-          if constexpr (uses_simd)
-            res.data ()[i] = std::experimental::min (data ()[i], rhs.data ()[i]);
-          else
-            for (size_t j = 0; j < items_per_block; ++j) {
-              auto pos = (i * items_per_block) + j;
-              res.at (pos) = std::min ((*this)[pos], rhs[pos]);
-            }
-
-          // In case of SIMD, this:
-          //   res.sum += std::experimental::reduce (res.data ()[i]);
-          // should NOT be used since this can lead to overflows over char.
-          // instead, we manually loop through:
-          if constexpr (HasSum)
-            for (size_t j = 0; j < items_per_block; ++j)
-              res.sum += res.data ()[i][j];
-        }
+        meet_into (res, *this, rhs);
+        return res;
+      }
+
+      // No allocation is made: the data of dst is overwritten.
+      static void meet_into (generic& dst, const generic& a, const generic& b) {
+        assert (a.k == b.k and dst.k == a.k);
+        kernels::meet (a.values (), b.values (), &dst.at (0), a.padded_size ());
+        dst.update_summaries ();
+      }
 
+      void meet_assign (const generic& rhs) { meet_into (*this, *this, rhs); }
+
+      [[nodiscard]] generic join (const generic& rhs) const {
+        auto res = generic (k);
+        kernels::join (values (), rhs.values (), &res.at (0), padded_size ());
+        res.update_summaries ();
         return res;
       }
 
+      void join_assign (const generic& rhs) {
+        assert (rhs.k == k);
+        kernels::join (values (), rhs.values (), &at (0), padded_size ());
+        update_summaries ();
+      }
+
       [[nodiscard]] auto size () const { return k; }
 
       auto& print (std::ostream& os) const {
@@ -223,6 +255,19 @@ namespace posets::vectors {
     private:
       value_type& at (size_t i) { return *(reinterpret_cast<value_type*> (data ()) + i); }
 
+      // Recompute the sum and the signature after the components changed.
+      // The sum is computed on the side, as a reduction over a SIMD block can
+      // overflow over char.
+      void update_summaries () {
+        if constexpr (HasSum) {
+          this->sum = 0;
+          for (size_t i = 0; i < k; ++i)
+            this->sum += at (i);
+        }
+        if constexpr (has_signature)
+          this->compute_signature (values (), k);
+      }
+
       [[nodiscard]] const value_type& at (size_t i) const {
         return *(reinterpret_cast<const value_type*> (data ()) + i);
       }
@@ -238,11 +283,14 @@ namespace posets::vectors {
       iterator end () { return iterator (data ()) + k; }
       [[nodiscard]] const_iterator end () const { return const_iterator (data ()) + k; }
 
-      [[nodiscard]] auto bin () const {
+      // Negative sums all go to bin 0, so that the bin grows with the vector.
+      [[nodiscard]] size_t bin () const {
+        long b;
         if constexpr (HasSum)
-          return std::abs (this->sum) / k;
+          b = this->sum;
         else
-          return std::abs ((*this)[0]) / k;  // NOLINT(clang-diagnostic-absolute-value)
+          b = (*this)[0];
+        return b <= 0 ? 0 : static_cast<size_t> (b) / k;
       }
 
     private:
@@ -1,6 +1,10 @@
 #pragma once
 
-#include <boost/pool/object_pool.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include <posets/utils/slab_pool.hh>
 
 namespace posets::vectors {
   template <typename T>
@@ -24,19 +28,73 @@ namespace posets::vectors {
   template <>
   struct sum_member<false> {};
 
-  /// Conditional member when embeds_data is unset in @a simd_array_backed_.
+  /// Conditional member when SignatureStep is nonzero in @a generic.  The
+  /// signature is a 64-bit summary of the vector such that if u dominates v,
+  /// then every bit set in v's signature is set in u's; a single and-not
+  /// thus often rules out domination without looking at the components.
+  /// Signatures are only comparable if they use the same Step, which is
+  /// why it is part of the vector type.
+  template <long Step>
+  struct signature_member {
+      uint64_t signature = 0;
+
+      // The components are split in (at most) 16 contiguous groups, and group
+      // g sets bit 4g + j iff the average of its components is at least
+      // 2^j * Step.
+      template <typename T>
+      void compute_signature (const T* values, size_t k) {
+        constexpr size_t ngroups = 16, nthresholds = 4;
+        signature = 0;
+        const size_t groups = std::min (ngroups, k);
+        for (size_t g = 0; g < groups; ++g) {
+          const size_t start = (g * k) / groups, end = ((g + 1) * k) / groups;
+          long sum = 0;
+          for (size_t i = start; i < end; ++i)
+            sum += values[i];
+          for (size_t j = 0; j < nthresholds; ++j)
+            if (sum >= (1L << j) * Step * static_cast<long> (end - start))
+              signature |= uint64_t {1} << ((g * nthresholds) + j);
+        }
+      }
+  };
+
+  template <>
+  struct signature_member<0> {};
+
+  /// Allocation policies for the data of @a generic when embeds_data is unset.
   template <typename Data>
   struct basic_malloc {
       static Data* construct () { return new Data (); }
       static void destroy (Data* d) { delete (d); }
   };
 
-  template <bool EmbedsData, typename Data>
+  /// Allocate from a per-thread slab pool.  The slabs are never given back to
+  /// the system, so that data can outlive the thread that allocated it.
+  /// Data freed by another thread goes back to the pool it came from (see
+  /// utils::slab_pool), so that the vectors built by worker threads and
+  /// dropped by the caller, as in parallel intersections, are reused.
+  template <typename Data>
+  struct slab_malloc {
+      using pool_type = utils::slab_pool<sizeof (Data), alignof (Data)>;
+
+      static pool_type& pool () {
+        thread_local pool_type pool {false};
+        return pool;
+      }
+
+      static Data* construct () { return new (pool ().allocate ()) Data (); }
+      static void destroy (Data* d) {
+        d->~Data ();
+        pool ().deallocate (d);
+      }
+  };
+
+  /// Conditional member when embeds_data is unset in @a simd_array_backed_.
+  template <bool EmbedsData, typename Data, template <typename> typename Malloc>
   struct malloc_member {
-      // static inline boost::object_pool<Data> malloc {8192};
-      static inline basic_malloc<Data> malloc;
+      static inline Malloc<Data> malloc;
   };
 
-  template <typename Data>
-  struct malloc_member<true, Data> {};
+  template <typename Data, template <typename> typename Malloc>
+  struct malloc_member<true, Data, Malloc> {};
 }
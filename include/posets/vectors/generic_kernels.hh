@@ -0,0 +1,277 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#include <posets/utils/cpu_dispatch.hh>
+
+/*
+ * The inner loops of generic vectors, on plain arrays of components.  They
+ * work on chunks of 64 bytes, then 16 bytes, then on single components, using
+ * GCC vector extensions: a 64-byte chunk is a single instruction with
+ * AVX-512, two with AVX2, and four with SSE.  The best variant for the CPU is
+ * selected at startup, see utils/cpu_dispatch.hh.
+ */
+
+namespace posets::vectors::kernels {
+  namespace details {
+    template <typename T, size_t Bytes>
+    struct vec {
+        using type [[gnu::vector_size (Bytes)]] = T;
+    };
+
+    // Vectors are passed by reference, as passing them by value would depend
+    // on the target.
+    template <size_t Bytes, typename T>
+    [[gnu::always_inline]] inline void load (typename vec<T, Bytes>::type& v, const T* p) {
+      std::memcpy (&v, p, Bytes);
+    }
+
+    // Whether some lane of a comparison result is set.
+    template <size_t Bytes, typename M>
+    [[gnu::always_inline]] inline bool any (const M& m) {
+      auto words = (typename vec<uint64_t, Bytes>::type) m;
+      uint64_t res = 0;
+      for (size_t i = 0; i < Bytes / sizeof (uint64_t); ++i)
+        res |= words[i];
+      return res != 0;
+    }
+
+    template <size_t Bytes, typename T>
+    [[gnu::always_inline]] inline void geq_leq (const T* a, const T* b, bool& geq, bool& leq) {
+      typename vec<T, Bytes>::type va, vb;
+      load<Bytes> (va, a);
+      load<Bytes> (vb, b);
+      geq = geq and not any<Bytes> (va < vb);
+      leq = leq and not any<Bytes> (va > vb);
+    }
+
+    template <size_t Bytes, typename T>
+    [[gnu::always_inline]] inline bool all_geq (const T* a, const T* b) {
+      typename vec<T, Bytes>::type va, vb;
+      load<Bytes> (va, a);
+      load<Bytes> (vb, b);
+      return not any<Bytes> (va < vb);
+    }
+
+    template <size_t Bytes, typename T>
+    [[gnu::always_inline]] inline void meet (const T* a, const T* b, T* out) {
+      typename vec<T, Bytes>::type va, vb;
+      load<Bytes> (va, a);
+      load<Bytes> (vb, b);
+      const typename vec<T, Bytes>::type res = va < vb ? va : vb;
+      std::memcpy (out, &res, Bytes);
+    }
+
+    template <size_t Bytes, typename T>
+    [[gnu::always_inline]] inline void join (const T* a, const T* b, T* out) {
+      typename vec<T, Bytes>::type va, vb;
+      load<Bytes> (va, a);
+      load<Bytes> (vb, b);
+      const typename vec<T, Bytes>::type res = va > vb ? va : vb;
+      std::memcpy (out, &res, Bytes);
+    }
+
+    template <size_t Bytes, typename T>
+    [[gnu::always_inline]] inline bool differ (const T* a, const T* b) {
+      typename vec<T, Bytes>::type va, vb;
+      load<Bytes> (va, a);
+      load<Bytes> (vb, b);
+      return any<Bytes> (va != vb);
+    }
+
+    template <size_t Bytes>
+    [[gnu::always_inline]] inline void superset_subset (const uint64_t* a, const uint64_t* b,
+                                                         bool& sup, bool& sub) {
+      typename vec<uint64_t, Bytes>::type va, vb;
+      load<Bytes> (va, a);
+      load<Bytes> (vb, b);
+      sup = sup and not any<Bytes> (vb & ~va);
+      sub = sub and not any<Bytes> (va & ~vb);
+    }
+
+    template <size_t Bytes, bool And>
+    [[gnu::always_inline]] inline void bits_op (const uint64_t* a, const uint64_t* b,
+                                                uint64_t* out) {
+      typename vec<uint64_t, Bytes>::type va, vb;
+      load<Bytes> (va, a);
+      load<Bytes> (vb, b);
+      const typename vec<uint64_t, Bytes>::type res = And ? (va & vb) : (va | vb);
+      std::memcpy (out, &res, Bytes);
+    }
+
+    template <typename T>
+    constexpr size_t wide = 64 / sizeof (T);
+
+    template <typename T>
+    constexpr size_t narrow = 16 / sizeof (T);
+  }
+
+  /// Compare a and b over n components, updating geq (resp. leq) to whether
+  /// a >= b (resp. a <= b) so far.  Stop early once one of them is false,
+  /// and return the number of components that were compared.
+  template <typename T>
+  POSETS_TARGET_CLONES size_t geq_leq (const T* a, const T* b, size_t n, bool& geq, bool& leq) {
+    using namespace details;
+    size_t i = 0;
+    for (; i + wide<T> <= n; i += wide<T>) {
+      details::geq_leq<64> (a + i, b + i, geq, leq);
+      if (not geq or not leq)
+        return i + wide<T>;
+    }
+    for (; i + narrow<T> <= n; i += narrow<T>) {
+      details::geq_leq<16> (a + i, b + i, geq, leq);
+      if (not geq or not leq)
+        return i + narrow<T>;
+    }
+    for (; i < n; ++i) {
+      geq = geq and a[i] >= b[i];
+      leq = leq and a[i] <= b[i];
+      if (not geq or not leq)
+        return i + 1;
+    }
+    return n;
+  }
+
+  /// Whether a >= b over n components.
+  template <typename T>
+  POSETS_TARGET_CLONES bool all_geq (const T* a, const T* b, size_t n) {
+    using namespace details;
+    size_t i = 0;
+    for (; i + wide<T> <= n; i += wide<T>)
+      if (not details::all_geq<64> (a + i, b + i))
+        return false;
+    for (; i + narrow<T> <= n; i += narrow<T>)
+      if (not details::all_geq<16> (a + i, b + i))
+        return false;
+    for (; i < n; ++i)
+      if (a[i] < b[i])
+        return false;
+    return true;
+  }
+
+  /// Store the componentwise minimum of a and b in out.
+  template <typename T>
+  POSETS_TARGET_CLONES void meet (const T* a, const T* b, T* out, size_t n) {
+    using namespace details;
+    size_t i = 0;
+    for (; i + wide<T> <= n; i += wide<T>)
+      details::meet<64> (a + i, b + i, out + i);
+    for (; i + narrow<T> <= n; i += narrow<T>)
+      details::meet<16> (a + i, b + i, out + i);
+    for (; i < n; ++i)
+      out[i] = a[i] < b[i] ? a[i] : b[i];
+  }
+
+  /// Store the componentwise maximum of a and b in out.
+  template <typename T>
+  POSETS_TARGET_CLONES void join (const T* a, const T* b, T* out, size_t n) {
+    using namespace details;
+    size_t i = 0;
+    for (; i + wide<T> <= n; i += wide<T>)
+      details::join<64> (a + i, b + i, out + i);
+    for (; i + narrow<T> <= n; i += narrow<T>)
+      details::join<16> (a + i, b + i, out + i);
+    for (; i < n; ++i)
+      out[i] = a[i] > b[i] ? a[i] : b[i];
+  }
+
+  /// A hash of the bytes of a[0..n).  Chunks of 64 bytes are mixed into eight
+  /// independent 64-bit lanes, which are then folded.
+  template <typename T>
+  POSETS_TARGET_CLONES size_t hash (const T* a, size_t n) {
+    using namespace details;
+    using lanes = typename vec<uint64_t, 64>::type;
+    constexpr uint64_t mul = 0x9E3779B97F4A7C15ULL;
+
+    const auto* bytes = reinterpret_cast<const unsigned char*> (a);
+    const size_t nbytes = n * sizeof (T);
+    lanes acc = {0, 1, 2, 3, 4, 5, 6, 7};
+    lanes chunk;
+    size_t i = 0;
+    for (; i + 64 <= nbytes; i += 64) {
+      std::memcpy (&chunk, bytes + i, 64);
+      acc = (acc ^ chunk) * mul;
+      acc ^= acc >> 29;
+    }
+    if (i < nbytes) {
+      chunk = lanes {};
+      std::memcpy (&chunk, bytes + i, nbytes - i);
+      acc = (acc ^ chunk) * mul;
+      acc ^= acc >> 29;
+    }
+
+    uint64_t h = nbytes;
+    for (size_t j = 0; j < 8; ++j)
+      h = (h ^ acc[j]) * mul;
+    return h ^ (h >> 32);
+  }
+
+  /// Whether a comes strictly before b in the lexicographic order.
+  template <typename T>
+  POSETS_TARGET_CLONES bool less (const T* a, const T* b, size_t n) {
+    using namespace details;
+    size_t i = 0;
+    // Skip the equal prefix by chunks, then find the first difference.
+    while (i + wide<T> <= n and not details::differ<64> (a + i, b + i))
+      i += wide<T>;
+    while (i + narrow<T> <= n and not details::differ<16> (a + i, b + i))
+      i += narrow<T>;
+    for (; i < n; ++i)
+      if (a[i] != b[i])
+        return a[i] < b[i];
+    return false;
+  }
+
+  /// Bitsets, as arrays of n words: update sup (resp. sub) to whether the
+  /// bits of a include (resp. are included in) those of b, stopping early
+  /// once both are false.
+  POSETS_TARGET_CLONES inline void superset_subset (const uint64_t* a, const uint64_t* b, size_t n,
+                                                    bool& sup, bool& sub) {
+    using namespace details;
+    size_t i = 0;
+    for (; i + wide<uint64_t> <= n and (sup or sub); i += wide<uint64_t>)
+      details::superset_subset<64> (a + i, b + i, sup, sub);
+    for (; i + narrow<uint64_t> <= n and (sup or sub); i += narrow<uint64_t>)
+      details::superset_subset<16> (a + i, b + i, sup, sub);
+    for (; i < n and (sup or sub); ++i) {
+      sup = sup and not (b[i] & ~a[i]);
+      sub = sub and not (a[i] & ~b[i]);
+    }
+  }
+
+  /// Store the intersection of the bitsets a and b in out.
+  POSETS_TARGET_CLONES inline void bits_and (const uint64_t* a, const uint64_t* b, uint64_t* out,
+                                             size_t n) {
+    using namespace details;
+    size_t i = 0;
+    for (; i + wide<uint64_t> <= n; i += wide<uint64_t>)
+      details::bits_op<64, true> (a + i, b + i, out + i);
+    for (; i + narrow<uint64_t> <= n; i += narrow<uint64_t>)
+      details::bits_op<16, true> (a + i, b + i, out + i);
+    for (; i < n; ++i)
+      out[i] = a[i] & b[i];
+  }
+
+  /// Store the union of the bitsets a and b in out.
+  POSETS_TARGET_CLONES inline void bits_or (const uint64_t* a, const uint64_t* b, uint64_t* out,
+                                            size_t n) {
+    using namespace details;
+    size_t i = 0;
+    for (; i + wide<uint64_t> <= n; i += wide<uint64_t>)
+      details::bits_op<64, false> (a + i, b + i, out + i);
+    for (; i + narrow<uint64_t> <= n; i += narrow<uint64_t>)
+      details::bits_op<16, false> (a + i, b + i, out + i);
+    for (; i < n; ++i)
+      out[i] = a[i] | b[i];
+  }
+
+  /// The number of bits set in a[0..n).
+  POSETS_TARGET_CLONES inline size_t popcount (const uint64_t* a, size_t n) {
+    size_t res = 0;
+    for (size_t i = 0; i < n; ++i)
+      res += std::popcount (a[i]);
+    return res;
+  }
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <posets/vectors/generic_kernels.hh>
+
 namespace posets::vectors {
   template <typename Vec>
   class generic_partial_order {
@@ -7,46 +9,24 @@ namespace posets::vectors {
       generic_partial_order (const Vec& lhs, const Vec& rhs)
         : lhs {lhs},
           rhs {rhs},
-          nblocks {lhs.data_size ()} {
+          nvalues {lhs.padded_size ()} {
         if constexpr (requires { lhs.sum; }) {
           bgeq = (lhs.sum >= rhs.sum);
-          if (not bgeq)
-            has_bgeq = true;
-
           bleq = (lhs.sum <= rhs.sum);
-          if (not bleq)
-            has_bleq = true;
-
-          if (has_bgeq or has_bleq)
-            return;
         }
-        for (up_to = 0; up_to < nblocks; ++up_to) {
-          if constexpr (Vec::uses_simd) {
-            bgeq = bgeq and (std::experimental::all_of (lhs.data ()[up_to] >= rhs.data ()[up_to]));
-            bleq = bleq and (std::experimental::all_of (lhs.data ()[up_to] <= rhs.data ()[up_to]));
-          }
-          else {
-            for (size_t i = 0; i < Vec::items_per_block; ++i) {
-              auto diff = lhs[(up_to * Vec::items_per_block) + i] -
-                          rhs[(up_to * Vec::items_per_block) + i];
-              bgeq = bgeq and (diff >= 0);
-              bleq = bleq and (diff <= 0);
-            }
-          }
-
-          // An alternative way:
-          // auto diff = lhs.data ()[up_to] - rhs.data ()[up_to];
-          // bgeq = bgeq and (std::experimental::reduce (diff, std::bit_or ()) >= 0);
-          // bleq = bleq and (std::experimental::reduce (-diff, std::bit_or ()) >= 0);
-          if (not bgeq)
-            has_bgeq = true;
-          if (not bleq)
-            has_bleq = true;
-          if (has_bgeq or has_bgeq)
-            return;
+        if constexpr (requires { lhs.signature; }) {
+          bgeq = bgeq and not (rhs.signature & ~lhs.signature);
+          bleq = bleq and not (lhs.signature & ~rhs.signature);
         }
-        has_bgeq = true;
-        has_bleq = true;
+        has_bgeq = not bgeq;
+        has_bleq = not bleq;
+        if (has_bgeq or has_bleq)
+          return;
+
+        // Compute both until one fails; the other one is computed lazily.
+        up_to = kernels::geq_leq (lhs.values (), rhs.values (), nvalues, bgeq, bleq);
+        has_bgeq = (not bgeq or up_to == nvalues);
+        has_bleq = (not bleq or up_to == nvalues);
       }
 
       bool geq () {
@@ -54,19 +34,7 @@ namespace posets::vectors {
           return bgeq;
         assert (has_bleq);
         has_bgeq = true;
-        for (; up_to < nblocks; ++up_to) {
-          if constexpr (Vec::uses_simd)
-            bgeq = bgeq and (std::experimental::all_of (lhs.data ()[up_to] >= rhs.data ()[up_to]));
-          else
-            for (size_t i = 0; i < Vec::items_per_block; ++i) {
-              auto diff = lhs[(up_to * Vec::items_per_block) + i] -
-                          rhs[(up_to * Vec::items_per_block) + i];
-              bgeq = bgeq and (diff >= 0);
-            }
-
-          if (not bgeq)
-            break;
-        }
+        bgeq = kernels::all_geq (lhs.values () + up_to, rhs.values () + up_to, nvalues - up_to);
         return bgeq;
       }
 
@@ -75,26 +43,14 @@ namespace posets::vectors {
           return bleq;
         assert (has_bgeq);
         has_bleq = true;
-        for (; up_to < nblocks; ++up_to) {
-          if constexpr (Vec::uses_simd)
-            bleq = bleq and (std::experimental::all_of (lhs.data ()[up_to] <= rhs.data ()[up_to]));
-          else
-            for (size_t i = 0; i < Vec::items_per_block; ++i) {
-              auto diff = lhs[(up_to * Vec::items_per_block) + i] -
-                          rhs[(up_to * Vec::items_per_block) + i];
-              bleq = bleq and (diff <= 0);
-            }
-
-          if (not bleq)
-            break;
-        }
+        bleq = kernels::all_geq (rhs.values () + up_to, lhs.values () + up_to, nvalues - up_to);
         return bleq;
       }
 
     private:
       const Vec& lhs;
       const Vec& rhs;
-      const size_t nblocks;
+      const size_t nvalues;
       bool bgeq = true, bleq = true;
       bool has_bgeq = false, has_bleq = false;
       size_t up_to = 0;
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <posets/concepts.hh>
+#include <posets/vectors/generic_kernels.hh>
+
+namespace posets::vectors {
+  /// A vector whose components live in a small range [Min, Min + 2^Bits - 1],
+  /// each packed in Bits bits of 64-bit words.  Comparisons and meets are
+  /// done a word at a time using SWAR (SIMD within a register) arithmetic, so
+  /// that 64 / Bits components are handled by a few integer instructions.
+  ///
+  /// Components are stored biased by -Min, so that all fields are
+  /// nonnegative; unused fields of the last word are kept at 0.
+  template <typename T, size_t Bits, T Min = (std::is_signed_v<T> ? -1 : 0)>
+  class packed {
+      static_assert (Bits == 2 or Bits == 4 or Bits == 8, "Unsupported field width.");
+
+      using word_t = uint64_t;
+
+    public:
+      using value_type = T;
+
+      static constexpr size_t items_per_word = sizeof (word_t) * 8 / Bits;
+      static constexpr T min_value = Min;
+      static constexpr auto max_value = static_cast<long long> (Min) + (1LL << Bits) - 1;
+
+      static constexpr size_t words_for (size_t nelts) {
+        return (nelts + items_per_word - 1) / items_per_word;
+      }
+
+    private:
+      static constexpr word_t field_mask = (word_t {1} << Bits) - 1;
+      // The lowest bit of each field.
+      static constexpr word_t low_bits = ~word_t {0} / field_mask;
+      // The highest bit of each field.
+      static constexpr word_t high_bits = low_bits << (Bits - 1);
+
+      // The highest bit of each field of the result is set iff that field of
+      // a is >= that of b; other bits are 0.  Setting the high bit of a and
+      // clearing that of b ensures that the subtraction does not borrow
+      // across fields, and gives the comparison on the low bits; the high bits
+      // are then compared separately.
+      static word_t geq_fields (word_t a, word_t b) {
+        const word_t low_geq = (a | high_bits) - (b & ~high_bits);
+        return ((a & ~b) | (~(a ^ b) & low_geq)) & high_bits;
+      }
+
+      // The fields of the result are all ones where a >= b, all zeros
+      // elsewhere: the high bit of each field is spread to the whole field.
+      static word_t geq_mask (word_t a, word_t b) {
+        return (geq_fields (a, b) >> (Bits - 1)) * field_mask;
+      }
+
+    public:
+      // All components are set to Min.
+      packed (size_t k) : k {k}, words (words_for (k), 0) {}
+
+      packed (std::span<const value_type> v) : packed (v.size ()) {
+        for (size_t i = 0; i < k; ++i) {
+          assert (v[i] >= Min and v[i] <= max_value);
+          words[i / items_per_word] |= static_cast<word_t> (v[i] - Min)
+                                       << ((i % items_per_word) * Bits);
+        }
+      }
+
+      packed () = delete;
+      packed (const packed& other) = delete;
+      packed (packed&& other) = default;
+
+    private:
+      packed (size_t k, std::vector<word_t>&& words) : k {k}, words {std::move (words)} {}
+
+    public:
+      // explicit copy operator
+      [[nodiscard]] packed copy () const { return packed (k, std::vector<word_t> (words)); }
+
+      packed& operator= (packed&& other) = default;
+      packed& operator= (const packed& other) = delete;
+
+      void to_vector (std::span<value_type> v) const {
+        assert (v.size () >= k);
+        for (size_t i = 0; i < k; ++i)
+          v[i] = (*this)[i];
+      }
+
+      class po_res {
+        public:
+          po_res (const packed& lhs, const packed& rhs) {
+            for (size_t i = 0; i < lhs.words.size () and (bgeq or bleq); ++i) {
+              const word_t l = lhs.words[i], r = rhs.words[i];
+              if (l == r)
+                continue;
+              bgeq = bgeq and geq_fields (l, r) == high_bits;
+              bleq = bleq and geq_fields (r, l) == high_bits;
+            }
+          }
+
+          bool geq () { return bgeq; }
+
+          bool leq () { return bleq; }
+
+        private:
+          bool bgeq = true, bleq = true;
+      };
+
+      [[nodiscard]] auto partial_order (const packed& rhs) const {
+        assert (rhs.k == k);
+        return po_res (*this, rhs);
+      }
+
+      bool operator== (const packed& rhs) const { return words == rhs.words; }
+
+      bool operator!= (const packed& rhs) const { return words != rhs.words; }
+
+      // Used by Sets, should be a total order.  Do not use.
+      bool operator< (const packed& rhs) const { return words < rhs.words; }
+
+      [[nodiscard]] size_t hash () const { return kernels::hash (words.data (), words.size ()); }
+
+      [[nodiscard]] size_t sort_key_size () const { return k; }
+
+      // One byte per component, biased, so that it is nonnegative.
+      void sort_key (std::span<unsigned char> key) const {
+        assert (key.size () >= k);
+        for (size_t i = 0; i < k; ++i)
+          key[i] = static_cast<unsigned char> (field (i));
+      }
+
+      [[nodiscard]] packed meet (const packed& rhs) const {
+        auto res = packed (k);
+        meet_into (res, *this, rhs);
+        return res;
+      }
+
+      static void meet_into (packed& dst, const packed& a, const packed& b) {
+        assert (a.k == b.k and dst.k == a.k);
+        for (size_t i = 0; i < a.words.size (); ++i) {
+          const word_t l = a.words[i], r = b.words[i];
+          const word_t l_geq_r = geq_mask (l, r);
+          dst.words[i] = (r & l_geq_r) | (l & ~l_geq_r);
+        }
+      }
+
+      void meet_assign (const packed& rhs) { meet_into (*this, *this, rhs); }
+
+      [[nodiscard]] packed join (const packed& rhs) const {
+        auto res = copy ();
+        res.join_assign (rhs);
+        return res;
+      }
+
+      void join_assign (const packed& rhs) {
+        assert (rhs.k == k);
+        for (size_t i = 0; i < words.size (); ++i) {
+          const word_t l = words[i], r = rhs.words[i];
+          const word_t l_geq_r = geq_mask (l, r);
+          words[i] = (l & l_geq_r) | (r & ~l_geq_r);
+        }
+      }
+
+      [[nodiscard]] auto size () const { return k; }
+
+      value_type operator[] (size_t i) const { return static_cast<value_type> (field (i) + Min); }
+
+      // The average of the biased components: summing the fields of a word is
+      // done bit plane by bit plane, with popcount.
+      [[nodiscard]] auto bin () const {
+        size_t sum = 0;
+        for (auto w : words)
+          for (size_t j = 0; j < Bits; ++j)
+            sum += static_cast<size_t> (std::popcount (w & (low_bits << j))) << j;
+        return sum / k;
+      }
+
+      std::ostream& print (std::ostream& os) const {
+        os << "{ ";
+        for (size_t i = 0; i < k; ++i)
+          os << (int) (*this)[i] << " ";
+        os << "}";
+        return os;
+      }
+
+    private:
+      // The biased value of component i.
+      [[nodiscard]] word_t field (size_t i) const {
+        assert (i < k);
+        return (words[i / items_per_word] >> ((i % items_per_word) * Bits)) & field_mask;
+      }
+
+      size_t k;
+      std::vector<word_t> words;
+  };
+}
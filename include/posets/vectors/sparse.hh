@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <posets/concepts.hh>
+#include <posets/vectors/generic_kernels.hh>
+
+namespace posets::vectors {
+  /// A vector for very high dimensions, most of whose components equal
+  /// Default.  It stores the other components as (index, value) pairs, sorted
+  /// by index, and compares and meets by merging them.
+  ///
+  /// Once the pairs would take more memory than the plain array of
+  /// components, the vector is stored as that array instead, and the dense
+  /// kernels are used.  The representation only depends on the number of
+  /// components that differ from Default, so that equal vectors are stored
+  /// alike.
+  template <typename T, T Default = (std::is_signed_v<T> ? -1 : 0)>
+  class sparse {
+      using index_t = uint32_t;
+
+    public:
+      using value_type = T;
+
+      static constexpr T default_value = Default;
+
+    private:
+      // Whether nnz components that differ from Default are stored densely.
+      static constexpr bool is_dense (size_t k, size_t nnz) {
+        return nnz * (sizeof (index_t) + sizeof (value_type)) > k * sizeof (value_type);
+      }
+
+    public:
+      // All components are set to Default.
+      sparse (size_t k) : k {static_cast<index_t> (k)} {}
+
+      sparse (std::span<const value_type> v) : sparse (v.size ()) {
+        const auto nnz = static_cast<size_t> (
+            std::ranges::count_if (v, [] (auto x) { return x != Default; }));
+        if (is_dense (k, nnz)) {
+          vals.assign (v.begin (), v.end ());
+          return;
+        }
+        idx.reserve (nnz);
+        vals.reserve (nnz);
+        for (size_t i = 0; i < k; ++i)
+          if (v[i] != Default) {
+            idx.push_back (static_cast<index_t> (i));
+            vals.push_back (v[i]);
+          }
+      }
+
+      sparse (std::initializer_list<value_type> v) : sparse (std::span (v.begin (), v.size ())) {}
+
+      sparse () = delete;
+      sparse (const sparse& other) = delete;
+      sparse (sparse&& other) = default;
+
+    private:
+      sparse (index_t k, std::vector<index_t>&& idx, std::vector<value_type>&& vals)
+        : k {k},
+          idx {std::move (idx)},
+          vals {std::move (vals)} {}
+
+    public:
+      // explicit copy operator
+      [[nodiscard]] sparse copy () const {
+        return sparse (k, std::vector<index_t> (idx), std::vector<value_type> (vals));
+      }
+
+      sparse& operator= (sparse&& other) = default;
+      sparse& operator= (const sparse& other) = delete;
+
+      [[nodiscard]] bool dense () const { return vals.size () == k and idx.empty () and k != 0; }
+
+      /// The number of components that are stored.
+      [[nodiscard]] size_t stored () const { return vals.size (); }
+
+      void to_vector (std::span<value_type> v) const {
+        assert (v.size () >= k);
+        if (dense ()) {
+          std::ranges::copy (vals, v.begin ());
+          return;
+        }
+        std::fill (v.begin (), v.begin () + k, Default);
+        for (size_t j = 0; j < idx.size (); ++j)
+          v[idx[j]] = vals[j];
+      }
+
+      class po_res {
+        public:
+          po_res (const sparse& lhs, const sparse& rhs) {
+            if (lhs.dense () and rhs.dense ()) {
+              const auto up_to =
+                  kernels::geq_leq (lhs.vals.data (), rhs.vals.data (), lhs.k, bgeq, bleq);
+              // geq_leq stops once one of them fails; finish the other.
+              if (bgeq and up_to < lhs.k)
+                bgeq = kernels::all_geq (lhs.vals.data () + up_to, rhs.vals.data () + up_to,
+                                         lhs.k - up_to);
+              if (bleq and up_to < lhs.k)
+                bleq = kernels::all_geq (rhs.vals.data () + up_to, lhs.vals.data () + up_to,
+                                         lhs.k - up_to);
+              return;
+            }
+            lhs.merge (rhs, [this] (size_t, value_type l, value_type r) {
+              bgeq = bgeq and l >= r;
+              bleq = bleq and l <= r;
+              return bgeq or bleq;
+            });
+          }
+
+          bool geq () { return bgeq; }
+
+          bool leq () { return bleq; }
+
+        private:
+          bool bgeq = true, bleq = true;
+      };
+
+      [[nodiscard]] auto partial_order (const sparse& rhs) const {
+        assert (rhs.k == k);
+        return po_res (*this, rhs);
+      }
+
+      bool operator== (const sparse& rhs) const { return idx == rhs.idx and vals == rhs.vals; }
+
+      bool operator!= (const sparse& rhs) const { return not (*this == rhs); }
+
+      // Used by Sets, should be a total order.  Do not use.
+      bool operator< (const sparse& rhs) const {
+        if (idx != rhs.idx)
+          return idx < rhs.idx;
+        return vals < rhs.vals;
+      }
+
+      [[nodiscard]] size_t hash () const {
+        return kernels::hash (vals.data (), vals.size ()) ^
+               (kernels::hash (idx.data (), idx.size ()) * 0x9E3779B97F4A7C15ULL);
+      }
+
+      [[nodiscard]] size_t sort_key_size () const { return k * sizeof (value_type); }
+
+      // As for generic vectors: components are written big-endian, with the
+      // sign bit flipped.
+      void sort_key (std::span<unsigned char> key) const {
+        using uvalue_type = std::make_unsigned_t<value_type>;
+        constexpr size_t nbytes = sizeof (value_type);
+        assert (key.size () >= sort_key_size ());
+        auto write = [&] (size_t i, value_type x) {
+          auto u = static_cast<uvalue_type> (x);
+          if constexpr (std::is_signed_v<value_type>)
+            u ^= uvalue_type {1} << ((nbytes * 8) - 1);
+          for (size_t b = 0; b < nbytes; ++b)
+            key[(i * nbytes) + b] = static_cast<unsigned char> (u >> ((nbytes - 1 - b) * 8));
+        };
+        if (dense ()) {
+          for (size_t i = 0; i < k; ++i)
+            write (i, vals[i]);
+          return;
+        }
+        for (size_t i = 0; i < k; ++i)
+          write (i, Default);
+        for (size_t j = 0; j < idx.size (); ++j)
+          write (idx[j], vals[j]);
+      }
+
+      [[nodiscard]] sparse meet (const sparse& rhs) const {
+        auto res = sparse (k);
+        combine_into<true> (res, *this, rhs);
+        return res;
+      }
+
+      static void meet_into (sparse& dst, const sparse& a, const sparse& b) {
+        combine_into<true> (dst, a, b);
+      }
+
+      void meet_assign (const sparse& rhs) { combine_into<true> (*this, *this, rhs); }
+
+      [[nodiscard]] sparse join (const sparse& rhs) const {
+        auto res = sparse (k);
+        combine_into<false> (res, *this, rhs);
+        return res;
+      }
+
+      void join_assign (const sparse& rhs) { combine_into<false> (*this, *this, rhs); }
+
+      [[nodiscard]] auto size () const { return static_cast<size_t> (k); }
+
+      value_type operator[] (size_t i) const {
+        assert (i < k);
+        if (dense ())
+          return vals[i];
+        auto it = std::ranges::lower_bound (idx, static_cast<index_t> (i));
+        if (it == idx.end () or *it != i)
+          return Default;
+        return vals[it - idx.begin ()];
+      }
+
+      // The average of the components, offset by Default, or 0 if negative.
+      [[nodiscard]] size_t bin () const {
+        long long sum = 0;
+        for (auto x : vals)
+          sum += static_cast<long long> (x) - Default;
+        return sum <= 0 ? 0 : static_cast<size_t> (sum) / k;
+      }
+
+      std::ostream& print (std::ostream& os) const {
+        os << "{ ";
+        for (size_t i = 0; i < k; ++i)
+          os << (int) (*this)[i] << " ";
+        os << "}";
+        return os;
+      }
+
+    private:
+      // Store the meet (or the join) of a and b in dst, reusing the storage
+      // of dst.  When dst is a or b, the pairs are merged in per-thread
+      // buffers, which are then swapped with those of dst.
+      template <bool Meet>
+      static void combine_into (sparse& dst, const sparse& a, const sparse& b) {
+        assert (a.k == b.k and dst.k == a.k);
+        if (a.dense () and b.dense ()) {
+          dst.idx.clear ();
+          dst.vals.resize (a.k);
+          if constexpr (Meet)
+            kernels::meet (a.vals.data (), b.vals.data (), dst.vals.data (), a.k);
+          else
+            kernels::join (a.vals.data (), b.vals.data (), dst.vals.data (), a.k);
+          dst.make_canonical ();
+          return;
+        }
+
+        const bool aliased = (&dst == &a or &dst == &b);
+        thread_local std::vector<index_t> tmp_idx;
+        thread_local std::vector<value_type> tmp_vals;
+        auto& res_idx = aliased ? tmp_idx : dst.idx;
+        auto& res_vals = aliased ? tmp_vals : dst.vals;
+        res_idx.clear ();
+        res_vals.clear ();
+        a.merge (b, [&] (size_t i, value_type l, value_type r) {
+          const auto m = Meet ? std::min (l, r) : std::max (l, r);
+          if (m != Default) {
+            res_idx.push_back (static_cast<index_t> (i));
+            res_vals.push_back (m);
+          }
+          return true;
+        });
+        if (aliased) {
+          std::swap (dst.idx, tmp_idx);
+          std::swap (dst.vals, tmp_vals);
+        }
+        dst.make_canonical ();
+      }
+
+      // Switch to the representation that the number of stored components
+      // calls for.
+      void make_canonical () {
+        if (dense ()) {
+          const auto nnz = static_cast<size_t> (
+              std::ranges::count_if (vals, [] (auto x) { return x != Default; }));
+          if (is_dense (k, nnz))
+            return;
+          idx.reserve (nnz);
+          size_t j = 0;
+          for (size_t i = 0; i < k; ++i)
+            if (vals[i] != Default) {
+              idx.push_back (static_cast<index_t> (i));
+              vals[j++] = vals[i];
+            }
+          vals.resize (j);
+        }
+        else if (is_dense (k, idx.size ())) {
+          std::vector<value_type> res (k, Default);
+          for (size_t j = 0; j < idx.size (); ++j)
+            res[idx[j]] = vals[j];
+          vals = std::move (res);
+          idx.clear ();
+        }
+      }
+
+      // Call f (i, lhs[i], rhs[i]) on the indices i where lhs or rhs store a
+      // component, in increasing order, while f returns true.
+      template <typename F>
+      void merge (const sparse& rhs, F&& f) const {
+        if (dense () or rhs.dense ()) {
+          const auto& d = dense () ? *this : rhs;
+          const auto& s = dense () ? rhs : *this;
+          size_t j = 0;
+          for (size_t i = 0; i < k; ++i) {
+            value_type sv = Default;
+            if (j < s.idx.size () and s.idx[j] == i)
+              sv = s.vals[j++];
+            if (not (dense () ? f (i, d.vals[i], sv) : f (i, sv, d.vals[i])))
+              return;
+          }
+          return;
+        }
+        size_t a = 0, b = 0;
+        while (a < idx.size () or b < rhs.idx.size ()) {
+          const index_t ia = a < idx.size () ? idx[a] : k;
+          const index_t ib = b < rhs.idx.size () ? rhs.idx[b] : k;
+          bool go_on;
+          if (ia == ib)
+            go_on = f (ia, vals[a++], rhs.vals[b++]);
+          else if (ia < ib)
+            go_on = f (ia, vals[a++], Default);
+          else
+            go_on = f (ib, Default, rhs.vals[b++]);
+          if (not go_on)
+            return;
+        }
+      }
+
+      index_t k;
+      std::vector<index_t> idx;  // Empty when dense.
+      std::vector<value_type> vals;
+  };
+}
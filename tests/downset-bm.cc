@@ -1,13 +1,12 @@
 // TODO : Sorting and Selection in Posets | SIAM Journal on Computing | Vol. 40, No. 3 | Society for Industrial and Applied Mathematics
 // SORTING AND SELECTION IN POSETS
 // Th. 4.5
-// For vector_backed (insertion based) remove insert, and allow constructor on list
-// insert only if non dominated, this would replace it
 // dynamic data structure (vector vs kdtree) by gaperez
 // bm on syntcomp
 
 #include <cassert>
 #include <span>
+#include <list>
 #include <memory>
 #include <ostream>
 #include <set>
@@ -279,6 +278,15 @@ namespace posets::vectors {
 
   template <typename T>
   using simd_array_ptr_backed_fixed = posets::vectors::simd_array_ptr_backed<T, DIMENSION>;
+
+  template <typename T>
+  using simd_array_ptr_backed_sig_fixed = posets::vectors::simd_array_ptr_backed_sig<T, DIMENSION>;
+
+  template <typename T>
+  using simd_array_ptr_backed_slab_fixed = posets::vectors::simd_array_ptr_backed_slab<T, DIMENSION>;
+
+  template <typename T>
+  using packed4_backed = posets::vectors::packed<T, 4>;
 }
 
 VECTOR_TYPES (
@@ -286,20 +294,27 @@ VECTOR_TYPES (
   posets::vectors::array_ptr_backed_fixed<test_value_type>,
   posets::vectors::simd_array_backed_fixed<test_value_type>,
   posets::vectors::simd_array_ptr_backed_fixed<test_value_type>,
+  posets::vectors::simd_array_ptr_backed_slab_fixed<test_value_type>,
+  posets::vectors::simd_array_ptr_backed_sig_fixed<test_value_type>,
   posets::vectors::simd_array_backed_sum_fixed<test_value_type>,
   posets::vectors::vector_backed<test_value_type>,
-  posets::vectors::simd_vector_backed<test_value_type>
+  posets::vectors::simd_vector_backed<test_value_type>,
+  posets::vectors::packed4_backed<test_value_type>,
+  posets::vectors::sparse<test_value_type>
   );
 
 using set_types = template_type_list<
   posets::downsets::kdtree_backed,
   posets::downsets::vector_or_kdtree_backed,
   posets::downsets::vector_backed,
+  posets::downsets::columnar_backed,
+  posets::downsets::interned_backed,
   posets::downsets::vector_backed_bin,
   posets::downsets::vector_backed_one_dim_split_intersection_only,
   posets::downsets::sharingtree_backed,
   posets::downsets::simple_sharingtree_backed,
-  posets::downsets::sharingtrie_backed
+  posets::downsets::sharingtrie_backed,
+  posets::downsets::adaptive_backed
   >;
 
 
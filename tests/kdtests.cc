@@ -1,11 +1,17 @@
+// The parallel paths of kdtree_backed are checked on several threads,
+// whatever the machine.
+#define POSETS_THREADS 4
+
 #include <cassert>
 #include <ostream>
+#include <random>
 #include <vector>
 #include <string>
 
 #include <posets/utils/kdtree.hh>
 #include <posets/vectors.hh>
 #include <posets/downsets/kdtree_backed.hh>
+#include <posets/downsets/vector_backed.hh>
 
 namespace utils = posets::utils;
 
@@ -1443,6 +1449,152 @@ int test() {
   return checkList(std::move (list));
 }
 
+// n vectors of dimension dim with components drawn uniformly in [lo, hi].
+std::vector<VType> random_vectors (std::mt19937& gen, size_t dim, int lo, int hi, size_t n) {
+  std::uniform_int_distribution<int> comp (lo, hi);
+  std::vector<VType> out;
+  out.reserve (n);
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<char> v (dim);
+    for (auto& x : v)
+      x = static_cast<char> (comp (gen));
+    out.push_back (VType (std::move (v)));
+  }
+  return out;
+}
+
+// Whether tree.dominates agrees with a scan of the tree on each query, and
+// also with strict domination if strict is set.
+bool check_against_scan (const utils::kdtree<VType>& tree, const std::vector<VType>& queries,
+                         bool strict) {
+  for (const auto& v : queries)
+    for (bool s : {false, strict}) {
+      bool expected = false;
+      for (const auto& e : tree) {
+        auto po = v.partial_order (e);
+        expected = expected or (po.leq () and not (s and po.geq ()));
+      }
+      if (tree.dominates (v, s) != expected)
+        return false;
+    }
+  return true;
+}
+
+// Insert random vectors one by one, so that the tree goes through buffer
+// flushes, merges, and removals, and compare with a vector_backed downset.
+int test_dynamic () {
+  using RefType = posets::downsets::vector_backed<VType>;
+  std::mt19937 gen (42);
+  auto random_vector = [&] () { return std::move (random_vectors (gen, 4, 0, 12, 1)[0]); };
+
+  SetType set (random_vector ());
+  RefType ref (set.begin ()->copy ());
+  for (auto& v : random_vectors (gen, 4, 0, 12, 2000)) {
+    const bool ref_inserted = ref.insert (v.copy ());
+    if (set.insert (std::move (v)) != ref_inserted) {
+      std::cerr << "insert disagrees with vector_backed" << std::endl;
+      return 1;
+    }
+    if (set.size () != ref.size ()) {
+      std::cerr << "size disagrees with vector_backed" << std::endl;
+      return 1;
+    }
+  }
+  for (const auto& v : random_vectors (gen, 4, 0, 12, 2000))
+    if (set.contains (v) != ref.contains (v)) {
+      std::cerr << "contains disagrees with vector_backed" << std::endl;
+      return 1;
+    }
+
+  // A small union goes through insert, a larger one through a rebuild.
+  for (size_t n : {2, 200}) {
+    std::vector<VType> small = random_vectors (gen, 4, 0, 12, n), small_ref;
+    for (const auto& v : small)
+      small_ref.push_back (v.copy ());
+    set.union_with (SetType (std::move (small)));
+    ref.union_with (RefType (std::move (small_ref)));
+    for (const auto& v : random_vectors (gen, 4, 0, 12, 500))
+      if (set.contains (v) != ref.contains (v)) {
+        std::cerr << "contains disagrees after union" << std::endl;
+        return 1;
+      }
+  }
+  return 0;
+}
+
+// The leaves hold several blocks of elements; compare with a plain scan.
+int test_buckets () {
+  std::mt19937 gen (7);
+  utils::kdtree<VType> tree (random_vectors (gen, 3, 0, 20, 1000));
+  if (not check_against_scan (tree, random_vectors (gen, 3, 0, 20, 2000), true)) {
+    std::cerr << "dominates disagrees with a scan" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Large trees are built in parallel, and split at approximate medians.
+int test_large_build () {
+  std::mt19937 gen (11);
+  utils::kdtree<VType> tree (random_vectors (gen, 6, 0, 100, 2 * KDTREE_SAMPLE_THRESHOLD));
+  if (not check_against_scan (tree, random_vectors (gen, 6, 0, 100, 200), false)) {
+    std::cerr << "dominates disagrees with a scan on a large tree" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Components with two values, as the booleans of x_and_bitset, are split
+// cleanly.
+int test_boolean_splits () {
+  std::mt19937 gen (13);
+  utils::kdtree<VType> tree (random_vectors (gen, 24, -1, 0, 3000));
+  if (not check_against_scan (tree, random_vectors (gen, 24, -1, 0, 1000), true)) {
+    std::cerr << "dominates disagrees with a scan on boolean components" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Large sets are filtered and intersected in parallel; compare with
+// vector_backed.
+int test_parallel_intersection () {
+  using RefType = posets::downsets::vector_backed<VType>;
+  if (utils::thread_pool::global ().size () != 4) {
+    std::cerr << "the thread pool does not have 4 threads" << std::endl;
+    return 1;
+  }
+  std::mt19937 gen (17);
+  auto v1 = random_vectors (gen, 5, 0, 60, 20000), v2 = random_vectors (gen, 5, 0, 60, 20000);
+  auto copies = [] (const std::vector<VType>& vs) {
+    std::vector<VType> out;
+    for (const auto& v : vs)
+      out.push_back (v.copy ());
+    return out;
+  };
+  RefType r1 (copies (v1)), r2 (copies (v2));
+  SetType s1 (std::move (v1)), s2 (std::move (v2));
+  if (s1.size () * s2.size () < KDTREE_PARALLEL_CUTOFF) {
+    std::cerr << "the sets are too small to be intersected in parallel" << std::endl;
+    return 1;
+  }
+  s1.intersect_with (s2);
+  r1.intersect_with (r2);
+  bool same = s1.size () == r1.size ();
+  for (const auto& v : s1)
+    same = same and r1.contains (v);
+  for (const auto& v : r1)
+    same = same and s1.contains (v);
+  for (const auto& v : random_vectors (gen, 5, 0, 60, 2000))
+    same = same and s1.contains (v) == r1.contains (v);
+  if (not same) {
+    std::cerr << "parallel intersection disagrees with vector_backed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
 int main(int argc, char* argv[]) {
-  return test();
+  return test() or test_dynamic () or test_buckets () or test_large_build () or
+         test_boolean_splits () or test_parallel_intersection ();
 }
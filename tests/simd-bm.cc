@@ -79,6 +79,15 @@ namespace posets::vectors {
 
   template <typename T>
   using simd_array_ptr_backed_fixed = posets::vectors::simd_array_ptr_backed<T, DIMENSION>;
+
+  template <typename T>
+  using simd_array_ptr_backed_sig_fixed = posets::vectors::simd_array_ptr_backed_sig<T, DIMENSION>;
+
+  template <typename T>
+  using simd_array_ptr_backed_slab_fixed = posets::vectors::simd_array_ptr_backed_slab<T, DIMENSION>;
+
+  template <typename T>
+  using packed4_backed = posets::vectors::packed<T, 4>;
 }
 
 VECTOR_TYPES (
@@ -86,11 +95,15 @@ VECTOR_TYPES (
   posets::vectors::array_ptr_backed_fixed<test_value_type>,
   posets::vectors::simd_array_backed_fixed<test_value_type>,
   posets::vectors::simd_array_ptr_backed_fixed<test_value_type>,
+  posets::vectors::simd_array_ptr_backed_slab_fixed<test_value_type>,
+  posets::vectors::simd_array_ptr_backed_sig_fixed<test_value_type>,
   posets::vectors::simd_array_backed_sum_fixed<test_value_type>,
   posets::vectors::vector_backed<test_value_type>,
-  posets::vectors::simd_vector_backed<test_value_type>);
+  posets::vectors::simd_vector_backed<test_value_type>,
+  posets::vectors::packed4_backed<test_value_type>);
 
 using set_types = template_type_list<posets::downsets::vector_backed,
+                                     posets::downsets::columnar_backed,
                                      posets::downsets::vector_backed_bin>;
 
 void usage (const char* progname) {
@@ -119,6 +132,8 @@ int main (int argc, char* argv[]) {
   auto implem = std::string ("posets::downsets::") + argv[1]
     + "<posets::vectors::" + argv[2] + (argv[2][strlen (argv[2]) - 1] == '>' ? " " : "") + ">";
 
+  std::cout << "SIMD kernels: " << utils::cpu_dispatch_target () << std::endl;
+
   try {
     posets::vectors::bool_threshold = 128;
     posets::vectors::bitset_threshold = 128;
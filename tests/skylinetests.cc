@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <posets/utils/skyline.hh>
+#include <posets/vectors.hh>
+
+namespace utils = posets::utils;
+
+using VType = posets::vectors::vector_backed<char>;
+
+std::vector<VType> vvtovv (const std::vector<std::vector<char>>& vv) {
+  std::vector<VType> out;
+  for (const auto& v : vv)
+    out.emplace_back (VType (std::vector<char> (v)));
+  return out;
+}
+
+std::vector<VType> copy (const std::vector<VType>& vs) {
+  std::vector<VType> out;
+  for (const auto& v : vs)
+    out.push_back (v.copy ());
+  return out;
+}
+
+std::vector<char> to_vector (const VType& v) {
+  std::vector<char> out (v.size ());
+  for (size_t i = 0; i < v.size (); ++i)
+    out[i] = v[i];
+  return out;
+}
+
+// The maximal elements, computed naively, sorted.
+std::vector<std::vector<char>> naive_maxima (const std::vector<VType>& vs) {
+  std::vector<std::vector<char>> out;
+  for (const auto& v : vs) {
+    bool dominated = false;
+    for (const auto& w : vs) {
+      auto po = v.partial_order (w);
+      if (po.leq () and not po.geq ()) {
+        dominated = true;
+        break;
+      }
+    }
+    if (not dominated)
+      out.push_back (to_vector (v));
+  }
+  std::ranges::sort (out);
+  out.erase (std::unique (out.begin (), out.end ()), out.end ());
+  return out;
+}
+
+std::vector<std::vector<char>> sorted (const std::vector<VType>& vs) {
+  std::vector<std::vector<char>> out;
+  for (const auto& v : vs)
+    out.push_back (to_vector (v));
+  std::ranges::sort (out);
+  return out;
+}
+
+int check (const std::vector<VType>& vs) {
+  const auto expected = naive_maxima (vs);
+  if (sorted (utils::skyline_bnl (copy (vs))) != expected) {
+    std::cerr << "skyline_bnl disagrees on " << vs.size () << " elements" << std::endl;
+    return 1;
+  }
+  if (sorted (utils::skyline_sfs (copy (vs))) != expected) {
+    std::cerr << "skyline_sfs disagrees on " << vs.size () << " elements" << std::endl;
+    return 1;
+  }
+  if (sorted (utils::skyline_dc (copy (vs))) != expected) {
+    std::cerr << "skyline_dc disagrees on " << vs.size () << " elements" << std::endl;
+    return 1;
+  }
+  if (sorted (utils::skyline (copy (vs))) != expected) {
+    std::cerr << "skyline disagrees on " << vs.size () << " elements" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Sort keys follow the lexicographic order, and hashes agree on equal vectors.
+int check_keys (const std::vector<VType>& vs) {
+  std::vector<unsigned char> k1 (vs[0].sort_key_size ()), k2 (k1.size ());
+  for (size_t i = 1; i < vs.size (); ++i) {
+    vs[i - 1].sort_key (k1);
+    vs[i].sort_key (k2);
+    const int cmp = std::memcmp (k1.data (), k2.data (), k1.size ());
+    const auto lex = to_vector (vs[i - 1]) <=> to_vector (vs[i]);
+    if ((cmp < 0) != (lex < 0) or (cmp == 0) != (lex == 0)) {
+      std::cerr << "sort keys disagree with the lexicographic order" << std::endl;
+      return 1;
+    }
+    if (cmp == 0 and vs[i - 1].hash () != vs[i].hash ()) {
+      std::cerr << "equal vectors have different hashes" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main () {
+  std::cout << "checking a known list" << std::endl;
+  if (check (vvtovv ({{1, 2, 3}, {3, 2, 1}, {1, 2, 3}, {0, 2, 3}, {3, 3, 0}, {2, 1, 0}, {3, 2, 1}})))
+    return 1;
+
+  std::cout << "checking random lists" << std::endl;
+  std::mt19937 gen (0);  // NOLINT(cert-msc51-cpp)
+  for (size_t dim : {1, 2, 3, 5, 8, 12}) {
+    for (size_t n : {1, 10, 100, 1000}) {
+      for (int range : {3, 20}) {
+        std::uniform_int_distribution<int> dist (-1, range);
+        std::vector<VType> vs;
+        for (size_t i = 0; i < n; ++i) {
+          std::vector<char> v (dim);
+          for (auto& c : v)
+            c = static_cast<char> (dist (gen));
+          vs.emplace_back (VType (std::move (v)));
+        }
+        if (check (vs) or check_keys (vs))
+          return 1;
+      }
+    }
+  }
+
+  std::cout << "all good" << std::endl;
+  return 0;
+}
@@ -318,14 +318,10 @@ struct test_t : public generic_test<void> {
         assert (tree.contains (VType (il {0, 0, 0, 0, 0})));
         assert (tree.contains (VType (il {6, 0, 9, 9, 7})));
         assert (tree.contains (VType (il {7, 0, 9, 9, 7})));
+        assert (tree.closure_size () == 27602);
       }
 
 
-      // Full set is so slow, this will never finish.
-      if constexpr (std::is_same<SetType, posets::downsets::full_set<VType>>::value)
-        return;
-
-
       auto F1i = vec_to_set (vvtovv ({
             {7, 0, 9, 9, 7},
             {8, 0, 9, 9, 6},
@@ -363,6 +359,7 @@ struct test_t : public generic_test<void> {
           }));
       assert (F.contains (VType (il {-1, 9, -1, 0, -1, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0})));
       assert (not F.contains (VType (il {-1, 9, -1, 0, -1, 9, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0})));
+      assert (F.closure_size () == 8937472);
     }
 
     void operator() () {
@@ -413,8 +410,20 @@ namespace posets::vectors {
   template <typename T>
   using simd_array_ptr_backed_sum_fixed = posets::vectors::simd_array_ptr_backed_sum<T, 10>;
 
+  template <typename T>
+  using simd_array_ptr_backed_sig_fixed = posets::vectors::simd_array_ptr_backed_sig<T, 10>;
+
+  template <typename T>
+  using simd_array_ptr_backed_slab_fixed = posets::vectors::simd_array_ptr_backed_slab<T, 10>;
+
+  template <typename T>
+  using packed4_backed = posets::vectors::packed<T, 4>;
+
   template <typename T>
   using simd_vector_and_bitset_backed = posets::vectors::x_and_bitset<posets::vectors::simd_vector_backed<T>, 1>;
+
+  template <typename T>
+  using simd_vector_and_bits_backed = posets::vectors::x_and_bits<posets::vectors::simd_vector_backed<T>>;
 }
 
 #define DEFINE_VECTOR_NAME(V) template <> struct vector_name<V> { static constexpr auto str = #V; };
@@ -430,9 +439,18 @@ VECTOR_TYPES (posets::vectors::vector_backed<char>,
               posets::vectors::simd_array_ptr_backed_fixed<char>,
               posets::vectors::simd_array_backed_sum_fixed<char>,
               posets::vectors::simd_array_ptr_backed_sum_fixed<char>,
-              posets::vectors::simd_vector_and_bitset_backed<char>);
-
-using set_types = template_type_list<//posets::downsets::full_set, ; too slow.
+              posets::vectors::simd_array_ptr_backed_slab_fixed<char>,
+              posets::vectors::simd_array_ptr_backed_sig_fixed<char>,
+              posets::vectors::simd_vector_backed_sig<char>,
+              posets::vectors::simd_vector_and_bitset_backed<char>,
+              posets::vectors::simd_vector_and_bits_backed<char>,
+              posets::vectors::packed4_backed<char>,
+              posets::vectors::sparse<char>);
+
+// full_set is not in the list: its size () counts all the points of the set,
+// not the maximal elements.  It is checked against vector_backed in
+// vectortests.
+using set_types = template_type_list<
   posets::downsets::sharingtree_backed,
   posets::downsets::simple_sharingtree_backed,
   posets::downsets::sharingtrie_backed,
@@ -440,8 +458,12 @@ using set_types = template_type_list<//posets::downsets::full_set, ; too slow.
   posets::downsets::vector_or_kdtree_backed,
   posets::downsets::set_backed,
   posets::downsets::vector_backed,
+  posets::downsets::columnar_backed,
+  posets::downsets::interned_backed,
   posets::downsets::vector_backed_bin,
-  posets::downsets::vector_backed_one_dim_split_intersection_only>;
+  posets::downsets::vector_backed_one_dim_split_intersection_only,
+  posets::downsets::adaptive_backed,
+  posets::downsets::bitmap_backed>;
 
 
 
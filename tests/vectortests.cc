@@ -0,0 +1,553 @@
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <posets/downsets/adaptive_backed.hh>
+#include <posets/downsets/bitmap_backed.hh>
+#include <posets/downsets/dimension_dispatched.hh>
+#include <posets/downsets/full_set.hh>
+#include <posets/downsets/interned_backed.hh>
+#include <posets/downsets/vector_backed.hh>
+#include <posets/downsets/vector_backed_bin.hh>
+#include <posets/utils/slab_pool.hh>
+#include <posets/vectors.hh>
+
+size_t posets::vectors::bool_threshold = 0;
+size_t posets::vectors::bitset_threshold = 0;
+
+namespace vectors = posets::vectors;
+
+using RType = vectors::vector_backed<char>;
+
+// Check the vector type V against the reference RType.  For types that split
+// their components, the components at and after split are booleans, i.e., -1
+// or 0.
+template <typename V>
+struct checker {
+    size_t split;
+
+    std::vector<char> values (const V& v) {
+      std::vector<char> out (v.size ());
+      v.to_vector (out);
+      for (size_t i = 0; i < v.size (); ++i)
+        if (out[i] != v[i])
+          throw std::runtime_error ("to_vector and operator[] disagree");
+      return out;
+    }
+
+    V make (const std::vector<char>& v) {
+      if constexpr (std::is_constructible_v<V, std::span<const char>, size_t>)
+        return V (std::span<const char> (v), split);
+      else
+        return V (std::span<const char> (v));
+    }
+
+    int check (const std::vector<std::vector<char>>& vv) {
+      std::vector<V> vs;
+      std::vector<RType> rs;
+      for (const auto& v : vv) {
+        vs.emplace_back (make (v));
+        rs.emplace_back (RType (std::span<const char> (v)));
+        if (values (vs.back ()) != v) {
+          std::cerr << "values are not preserved" << std::endl;
+          return 1;
+        }
+      }
+
+      std::vector<unsigned char> k1 (vs[0].sort_key_size ()), k2 (k1.size ());
+      for (size_t i = 0; i < vs.size (); ++i) {
+        if (vs[i].copy () != vs[i] or vs[i] < vs[i]) {
+          std::cerr << "copy or order is wrong" << std::endl;
+          return 1;
+        }
+        for (size_t j = 0; j < vs.size (); ++j) {
+          auto po = vs[i].partial_order (vs[j]);
+          auto rpo = rs[i].partial_order (rs[j]);
+          if (po.geq () != rpo.geq () or po.leq () != rpo.leq ()) {
+            std::cerr << "partial orders disagree" << std::endl;
+            return 1;
+          }
+          if ((vs[i] == vs[j]) != (vv[i] == vv[j]) or
+              (vs[i] == vs[j]) == (vs[i] < vs[j] or vs[j] < vs[i])) {
+            std::cerr << "equality or total order is wrong" << std::endl;
+            return 1;
+          }
+          if (vs[i] == vs[j] and vs[i].hash () != vs[j].hash ()) {
+            std::cerr << "equal vectors have different hashes" << std::endl;
+            return 1;
+          }
+          vs[i].sort_key (k1);
+          vs[j].sort_key (k2);
+          const int cmp = std::memcmp (k1.data (), k2.data (), k1.size ());
+          const auto lex = vv[i] <=> vv[j];
+          if ((cmp < 0) != (lex < 0) or (cmp == 0) != (lex == 0)) {
+            std::cerr << "sort keys disagree with the lexicographic order" << std::endl;
+            return 1;
+          }
+          std::vector<char> rmeet (vv[i].size ()), rjoin (vv[i].size ());
+          for (size_t c = 0; c < vv[i].size (); ++c) {
+            rmeet[c] = std::min (vv[i][c], vv[j][c]);
+            rjoin[c] = std::max (vv[i][c], vv[j][c]);
+          }
+          if (values (vs[i].meet (vs[j])) != rmeet) {
+            std::cerr << "meets disagree" << std::endl;
+            return 1;
+          }
+          if constexpr (posets::LatticeVector<V>) {
+            auto dst = vs[(i + 1) % vs.size ()].copy ();
+            V::meet_into (dst, vs[i], vs[j]);
+            auto m = vs[i].copy ();
+            m.meet_assign (vs[j]);
+            if (values (dst) != rmeet or values (m) != rmeet or dst != vs[i].meet (vs[j])) {
+              std::cerr << "in-place meets disagree" << std::endl;
+              return 1;
+            }
+            auto jn = vs[i].copy ();
+            jn.join_assign (vs[j]);
+            if (values (vs[i].join (vs[j])) != rjoin or values (jn) != rjoin) {
+              std::cerr << "joins disagree" << std::endl;
+              return 1;
+            }
+          }
+        }
+      }
+      return 0;
+    }
+};
+
+template <typename V>
+int check_random (std::mt19937& gen, size_t dim, size_t split, size_t n) {
+  std::uniform_int_distribution<int> xdist (-1, 3), bdist (-1, 0);
+  std::vector<std::vector<char>> vv;
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<char> v (dim);
+    for (size_t j = 0; j < dim; ++j)
+      v[j] = static_cast<char> (j < split ? xdist (gen) : bdist (gen));
+    vv.push_back (std::move (v));
+  }
+  // A few vectors that differ from others only in their booleans.
+  for (size_t i = 0; i + 1 < n; i += 2) {
+    vv[i + 1] = vv[i];
+    if (split < dim)
+      vv[i + 1][dim - 1 - (i % (dim - split))] = 0;
+  }
+  return checker<V> {split}.check (vv);
+}
+
+// Vectors with a proportion density of components that are not -1.
+template <typename V>
+int check_sparse (std::mt19937& gen, size_t dim, double density, size_t n) {
+  std::uniform_int_distribution<int> dist (-3, 5);
+  std::bernoulli_distribution nondefault (density);
+  std::vector<std::vector<char>> vv;
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<char> v (dim, -1);
+    for (auto& c : v)
+      if (nondefault (gen))
+        c = static_cast<char> (dist (gen));
+    vv.push_back (std::move (v));
+  }
+  // Some vectors dominated by others.
+  for (size_t i = 0; i + 1 < n; i += 3)
+    for (size_t j = 0; j < dim; ++j)
+      vv[i + 1][j] = std::min (vv[i][j], vv[i + 1][j]);
+  return checker<V> {0}.check (vv);
+}
+
+// Downsets sharing a store share their vectors, and give them back.
+int check_store () {
+  using V = vectors::vector_backed<char>;
+  using D = posets::downsets::interned_backed<V>;
+  auto store = std::make_shared<posets::utils::vector_store<V>> ();
+  posets::utils::vector_store<V>::scope scope (store);
+  auto vs = [] (std::vector<std::vector<char>> vv) {
+    std::vector<V> out;
+    for (auto& v : vv)
+      out.emplace_back (V (std::span<const char> (v)));
+    return out;
+  };
+  {
+    D d1 (vs ({{3, 0, 1}, {0, 3, 1}, {1, 1, 1}}));
+    D d2 (vs ({{3, 0, 1}, {1, 2, 3}}));
+    if (store->size () != 4) {
+      std::cerr << "equal vectors are stored twice" << std::endl;
+      return 1;
+    }
+    auto d3 = d1.apply ([] (const V& v) { return v.copy (); });
+    d3.intersect_with (d2);
+    // {3, 0, 1} is shared, and the meets are {0, 2, 1} and {1, 1, 1}.
+    if (d3.size () != 3 or not d3.contains (V (std::vector<char> {0, 2, 1}))) {
+      std::cerr << "wrong intersection" << std::endl;
+      return 1;
+    }
+    d1.union_with (std::move (d2));
+    if (d1.size () != 3) {
+      std::cerr << "wrong union" << std::endl;
+      return 1;
+    }
+  }
+  if (store->size () != 0) {
+    std::cerr << "vectors are not released" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// vector_backed_bin only looks at the bins that can hold a dominating
+// vector, which requires the bins of V to grow with the vectors, including
+// below zero.
+template <typename V>
+int check_bins (std::mt19937& gen) {
+  using D = posets::downsets::vector_backed_bin<V>;
+  using R = posets::downsets::vector_backed<RType>;
+  auto v = [] (const std::vector<char>& c) { return V (std::span<const char> (c)); };
+  D d (v ({-2, -2}));
+  if (not d.insert (v ({-1, -1})) or d.size () != 1 or not d.contains (v ({-2, -2}))) {
+    std::cerr << "vector_backed_bin misses a dominating vector" << std::endl;
+    return 1;
+  }
+
+  std::uniform_int_distribution<int> dist (-4, 2);
+  auto random_vectors = [&] (size_t n) {
+    std::vector<std::vector<char>> vv (n, std::vector<char> (6));
+    for (auto& u : vv)
+      for (auto& c : u)
+        c = static_cast<char> (dist (gen));
+    return vv;
+  };
+  for (int round = 0; round < 20; ++round) {
+    auto v1 = random_vectors (30), v2 = random_vectors (30), queries = random_vectors (100);
+    std::vector<V> e1, e2;
+    std::vector<RType> r1, r2;
+    for (const auto& u : v1) {
+      e1.push_back (v (u));
+      r1.emplace_back (RType (std::span<const char> (u)));
+    }
+    for (const auto& u : v2) {
+      e2.push_back (v (u));
+      r2.emplace_back (RType (std::span<const char> (u)));
+    }
+    D d1 (std::move (e1)), d2 (std::move (e2));
+    R s1 (std::move (r1)), s2 (std::move (r2));
+    d1.union_with (std::move (d2));
+    s1.union_with (std::move (s2));
+    if (d1.size () != s1.size ()) {
+      std::cerr << "vector_backed_bin union is not an antichain" << std::endl;
+      return 1;
+    }
+    for (const auto& q : queries)
+      if (d1.contains (v (q)) != s1.contains (RType (std::span<const char> (q)))) {
+        std::cerr << "vector_backed_bin membership disagrees" << std::endl;
+        return 1;
+      }
+  }
+  return 0;
+}
+
+// adaptive_backed moves to a backend that its cost model favours only once
+// the savings pay for the conversion, and not at all if the backend is not
+// cheaper by the hysteresis factor; the set is unchanged by a switch.  The
+// costs do not depend on the sizes, and only unions cost anything, so that
+// the predicted savings of a union are between 2/3 and 1 times the
+// difference of the union costs.
+int check_adaptive (std::mt19937& gen) {
+  using D = posets::downsets::adaptive_backed<
+      RType, posets::downsets::backend_list<posets::downsets::vector_backed,
+                                            posets::downsets::kdtree_backed>>;
+  using R = posets::downsets::vector_backed<RType>;
+  using law = posets::downsets::power_law;
+  const size_t dim = 5;
+  std::uniform_int_distribution<int> dist (0, 3);
+  auto random_vectors = [&] (size_t n) {
+    std::vector<std::vector<char>> vv (n, std::vector<char> (dim));
+    for (auto& v : vv)
+      for (auto& c : v)
+        c = static_cast<char> (dist (gen));
+    return vv;
+  };
+  auto make = [] (const std::vector<std::vector<char>>& vv) {
+    std::vector<RType> out;
+    for (const auto& v : vv)
+      out.emplace_back (RType (std::span<const char> (v)));
+    return out;
+  };
+  // Backend 0 unites at cost 1 and builds for free; backend 1 unites at
+  // cost cheap and builds at cost build.
+  auto run = [&] (double cheap, double build, size_t rounds) {
+    D::set_costs (dim, {posets::downsets::backend_costs {{0, 0}, {0, 0}, {1, 0}, {0, 0}},
+                        posets::downsets::backend_costs {{build, 0}, {0, 0}, {cheap, 0}, {0, 0}}});
+    const auto init = random_vectors (10);
+    D d (make (init));
+    R r (make (init));
+    std::vector<size_t> backends {d.backend ()};
+    for (size_t i = 0; i < rounds; ++i) {
+      const auto more = random_vectors (10);
+      d.union_with (D (make (more)));
+      r.union_with (R (make (more)));
+      backends.push_back (d.backend ());
+    }
+    bool same = d.size () == r.size () and d.closure_size () == r.closure_size ();
+    for (const auto& v : r)
+      same = same and d.contains (v);
+    return std::pair {backends, same};
+  };
+
+  // The regret reaches the build cost of 3 after 4 or 5 unions.
+  auto [backends, same] = run (.1, 3, 8);
+  if (backends[0] != 0 or backends[3] != 0 or backends[5] != 1 or backends[8] != 1 or not same) {
+    std::cerr << "adaptive_backed does not switch when the savings pay for it" << std::endl;
+    return 1;
+  }
+  // Cheaper, but not by the hysteresis factor: without it, the savings would
+  // pay for the build after at most 4 unions.
+  std::tie (backends, same) = run (.6, 1, 8);
+  if (std::ranges::count (backends, 0) != 9 or not same) {
+    std::cerr << "adaptive_backed switches to a backend that is not cheaper enough" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Objects freed through another pool, from another thread, go back to the
+// pool they came from, which then stops growing.
+int check_slab_pool () {
+  posets::utils::slab_pool<24, 8> owner, other;
+  std::vector<void*> objects;
+  size_t nslabs = 0;
+  for (int round = 0; round < 50; ++round) {
+    for (int i = 0; i < 100000; ++i)
+      objects.push_back (owner.allocate ());
+    std::thread ([&] {
+      for (auto* p : objects)
+        other.deallocate (p);
+    }).join ();
+    objects.clear ();
+    if (round == 0)
+      nslabs = owner.nslabs ();
+  }
+  if (owner.nslabs () != nslabs or other.nslabs () != 0) {
+    std::cerr << "objects freed remotely are not reused" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// full_set agrees with vector_backed on random generators.  Each generator
+// has one component at top and the others in {-1, 0, 1}, so that the sets
+// stay small while their bounding box has (top + 2)^dim points: this goes
+// through the bitmap, hash set, or unranked closure depending on dim.
+int check_full_set (std::mt19937& gen, size_t dim, char top, size_t n) {
+  using F = posets::downsets::full_set<RType>;
+  using R = posets::downsets::vector_backed<RType>;
+  std::uniform_int_distribution<int> small (-1, 1);
+  auto random_vectors = [&] (size_t count) {
+    std::vector<std::vector<char>> vv (count, std::vector<char> (dim));
+    for (size_t j = 0; j < count; ++j) {
+      for (auto& c : vv[j])
+        c = static_cast<char> (small (gen));
+      vv[j][j % dim] = top;
+    }
+    return vv;
+  };
+  auto to_rtypes = [] (const std::vector<std::vector<char>>& vv) {
+    std::vector<RType> out;
+    for (const auto& v : vv)
+      out.emplace_back (RType (std::span<const char> (v)));
+    return out;
+  };
+  auto agree = [&] (const F& f, const R& r, const std::vector<std::vector<char>>& queries) {
+    if (f.closure_size () != r.closure_size ())
+      return false;
+    for (const auto& q : queries)
+      if (f.contains (RType (std::span<const char> (q))) !=
+          r.contains (RType (std::span<const char> (q))))
+        return false;
+    for (const auto& e : f)
+      if (not r.contains (e))
+        return false;
+    return true;
+  };
+
+  auto v1 = random_vectors (n), v2 = random_vectors (n), queries = random_vectors (50);
+  for (auto& q : queries)
+    q[gen () % dim] = static_cast<char> (small (gen));
+  queries.insert (queries.end (), v1.begin (), v1.end ());
+  queries.insert (queries.end (), v2.begin (), v2.end ());
+
+  F f1 (to_rtypes (v1)), f2 (to_rtypes (v2));
+  R r1 (to_rtypes (v1)), r2 (to_rtypes (v2));
+  if (not agree (f1, r1, queries) or not agree (f2, r2, queries)) {
+    std::cerr << "full_set closure disagrees in dimension " << dim << std::endl;
+    return 1;
+  }
+
+  auto f3 = f1.apply ([] (const auto& v) { return v.copy (); });
+  auto r3 = r1.apply ([] (const auto& v) { return v.copy (); });
+  f3.intersect_with (f2);
+  r3.intersect_with (r2);
+  f1.union_with (f2);
+  r1.union_with (std::move (r2));
+  if (not agree (f3, r3, queries) or not agree (f1, r1, queries)) {
+    std::cerr << "full_set union or intersection disagrees in dimension " << dim << std::endl;
+    return 1;
+  }
+
+  // Inserting into a nonempty set marks its points as seen first.
+  auto extra = random_vectors (1);
+  f3.insert (RType (std::span<const char> (extra[0])));
+  r3.union_with (R (RType (std::span<const char> (extra[0]))));
+  if (not agree (f3, r3, queries)) {
+    std::cerr << "full_set insertion disagrees in dimension " << dim << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// The box of a bitmap_backed set follows its elements: it does not grow when
+// unions lower its corner, and it shrinks with intersections.  A box that
+// is too large is an error, not a huge bitmap.
+int check_bitmap_backed () {
+  using D = posets::downsets::bitmap_backed<RType>;
+  auto v = [] (std::vector<char> c) { return RType (std::span<const char> (c)); };
+  D d (v ({12, 12, 12, 12}));
+  for (char k = 11; k >= -1; --k)
+    d.union_with (D (v ({k, k, k, k})));
+  if (d.size () != 1 or not d.contains (v ({12, 12, 12, 12})) or d.contains (v ({13, 0, 0, 0}))) {
+    std::cerr << "wrong union of bitmap_backed sets" << std::endl;
+    return 1;
+  }
+
+  D far (v ({100, 100, 100, 100}));
+  far.intersect_with (D (v ({-1, 0, 100, 100})));
+  far.intersect_with (d);
+  if (far.size () != 1 or not far.contains (v ({-1, 0, 12, 12})) or
+      far.contains (v ({0, 0, 0, 0}))) {
+    std::cerr << "wrong intersection of bitmap_backed sets" << std::endl;
+    return 1;
+  }
+
+  try {
+    D huge (v ({0, 0, 0, 0, 0}));
+    huge.union_with (D (v ({100, 100, 100, 100, 100})));
+    std::cerr << "oversized bitmap_backed box is accepted" << std::endl;
+    return 1;
+  }
+  catch (const std::length_error&) {}
+  return 0;
+}
+
+// A downset of runtime dimension agrees with the same downset on
+// vector_backed, and lands in the expected bucket.
+int check_dispatch (std::mt19937& gen, size_t dim, size_t bucket) {
+  using D = posets::downsets::dimension_dispatched<posets::downsets::vector_backed, char>;
+  using R = posets::downsets::vector_backed<RType>;
+  std::uniform_int_distribution<int> dist (-1, 4);
+  auto random_vectors = [&] (size_t n) {
+    std::vector<std::vector<char>> vv (n, std::vector<char> (dim));
+    for (auto& v : vv)
+      for (auto& c : v)
+        c = static_cast<char> (dist (gen));
+    return vv;
+  };
+  auto to_rtypes = [] (const std::vector<std::vector<char>>& vv) {
+    std::vector<RType> out;
+    for (const auto& v : vv)
+      out.emplace_back (RType (std::span<const char> (v)));
+    return out;
+  };
+
+  auto v1 = random_vectors (20), v2 = random_vectors (20), queries = random_vectors (50);
+  D d1 (v1), d2 (v2);
+  R r1 (to_rtypes (v1)), r2 (to_rtypes (v2));
+  if (d1.bucket () != bucket) {
+    std::cerr << "dimension " << dim << " is in the wrong bucket" << std::endl;
+    return 1;
+  }
+  d1.intersect_with (d2);
+  r1.intersect_with (r2);
+  auto d3 = d1.apply ([] (const auto& v) { return v.copy (); });
+  d3.union_with (D (random_vectors (1)[0]));
+  if (d1.size () != r1.size () or d3.size () == 0) {
+    std::cerr << "sizes disagree" << std::endl;
+    return 1;
+  }
+  for (const auto& q : queries)
+    if (d1.contains (q) != r1.contains (RType (std::span<const char> (q)))) {
+      std::cerr << "membership disagrees" << std::endl;
+      return 1;
+    }
+  size_t n = 0;
+  d1.for_each ([&] (std::span<const char> v) { n += r1.contains (RType (v)); });
+  if (n != r1.size ()) {
+    std::cerr << "elements disagree" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main () {
+  std::mt19937 gen (0);  // NOLINT(cert-msc51-cpp)
+
+  std::cout << "checking x_and_bits" << std::endl;
+  using XB = vectors::x_and_bits<vectors::vector_backed<char>>;
+  using SXB = vectors::x_and_bits<vectors::simd_vector_backed<char>>;
+  for (auto [dim, split] : {std::pair {10, 4}, {10, 10}, {10, 0}, {70, 3}, {300, 20}, {2000, 7}})
+    for (size_t n : {2, 30})
+      if (check_random<XB> (gen, dim, split, n) or check_random<SXB> (gen, dim, split, n))
+        return 1;
+
+  std::cout << "checking generic and packed" << std::endl;
+  for (size_t dim : {1, 10, 100})
+    for (size_t n : {2, 30})
+      if (check_random<vectors::vector_backed<char>> (gen, dim, dim, n) or
+          check_random<vectors::simd_array_ptr_backed_sum<char, 100>> (gen, dim, dim, n) or
+          check_random<vectors::simd_vector_backed_sig<char>> (gen, dim, dim, n) or
+          check_random<vectors::simd_vector_backed_sig<char, 2>> (gen, dim, dim, n) or
+          check_random<vectors::packed<char, 4>> (gen, dim, dim, n))
+        return 1;
+
+  std::cout << "checking sparse" << std::endl;
+  for (size_t dim : {1, 10, 300, 5000})
+    for (double density : {0.0, 0.01, 0.1, 0.5, 1.0})
+      for (size_t n : {2, 20})
+        if (check_sparse<vectors::sparse<char>> (gen, dim, density, n))
+          return 1;
+
+  std::cout << "checking vector_store" << std::endl;
+  if (check_store ())
+    return 1;
+
+  std::cout << "checking bins" << std::endl;
+  if (check_bins<vectors::vector_backed<char>> (gen) or
+      check_bins<vectors::vector_backed_sum<char>> (gen))
+    return 1;
+
+  std::cout << "checking adaptive_backed" << std::endl;
+  if (check_adaptive (gen))
+    return 1;
+
+  std::cout << "checking slab_pool" << std::endl;
+  if (check_slab_pool ())
+    return 1;
+
+  std::cout << "checking bitmap_backed" << std::endl;
+  if (check_bitmap_backed ())
+    return 1;
+
+  std::cout << "checking full_set" << std::endl;
+  // Bitmap, hash set, and unranked closures.
+  for (auto [dim, top] : {std::pair {3, 20}, {8, 120}, {10, 120}})
+    if (check_full_set (gen, dim, static_cast<char> (top), 12))
+      return 1;
+
+  std::cout << "checking dimension dispatch" << std::endl;
+  for (auto [dim, bucket] : {std::pair {3, 8}, {8, 8}, {9, 16}, {100, 128}, {1024, 1024}, {1500, 0}})
+    if (check_dispatch (gen, dim, bucket))
+      return 1;
+
+  std::cout << "all good" << std::endl;
+  return 0;
+}